@@ -0,0 +1,32 @@
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#include "alloc-count.h"
+using namespace std;
+
+static atomic<long> numAllocations(0);
+
+long getAllocationCount()
+{
+  return numAllocations.load(memory_order_relaxed);
+}
+
+/**
+ * The nothrow and array forms of operator new all forward to this one,
+ * so it's the only one that needs counting.  Every operator delete forwards
+ * to the plain one, which has to be replaced as well since it must release
+ * memory the way this operator new acquired it.
+ */
+
+void *operator new(size_t size)
+{
+  numAllocations.fetch_add(1, memory_order_relaxed);
+  void *memory = malloc(size == 0 ? 1 : size);
+  if (memory == NULL) throw bad_alloc();
+  return memory;
+}
+
+void operator delete(void *memory) noexcept
+{
+  free(memory);
+}
@@ -0,0 +1,16 @@
+#ifndef __alloc_count__
+#define __alloc_count__
+
+/**
+ * Function: getAllocationCount
+ * ----------------------------
+ * Returns the number of heap allocations (calls to operator new, in any of
+ * its forms, from any thread) made since the program started.  The count is
+ * kept by replacement operator news in alloc-count.cc, so it's only available
+ * to programs that link that file in; the benchmarks do, so they can report
+ * how many allocations a steady-state query costs.
+ */
+
+long getAllocationCount();
+
+#endif
@@ -0,0 +1,57 @@
+#include <string>
+#include <iostream>
+#include "imdb.h"
+#include "imdb-graph.h"
+#include "costar-graph.h"
+using namespace std;
+
+/**
+ * Function: main
+ * --------------
+ * Converts the actordata and moviedata files in the specified directory
+ * into a compressed-sparse-row graph snapshot (see imdbGraph), written
+ * alongside them as graphdata.  Every imdb constructed over that directory
+ * afterwards loads it, and the "graph" search engine runs on it.
+ *
+ * With --costars, the deduplicated co-star adjacency (see costarGraph) is
+ * then derived from the snapshot and written as costardata, for the
+ * "costars" search engine.
+ *
+ * Usage: build-graph [--costars] [data-directory]
+ */
+
+int main(int argc, const char *argv[])
+{
+  bool buildCostars = false;
+  const char *dataDirectory = NULL;
+  for (int i = 1; i < argc; i++) {
+    if (string(argv[i]) == "--costars") buildCostars = true;
+    else dataDirectory = argv[i];
+  }
+  string directory = determinePathToData(dataDirectory);
+  imdb db(directory);
+  if (!db.good()) { cerr << db.getLoadErrorMessage() << "  Aborting..." << endl; return 1; }
+
+  if (!imdbGraph::write(directory + "/graphdata", db)) {
+    cerr << "Couldn't write the graph snapshot.  Aborting..." << endl;
+    return 1;
+  }
+  cout << "Wrote a graph of " << db.getNumActors() << " actors and "
+       << db.getNumMovies() << " movies." << endl;
+  if (!buildCostars) return 0;
+
+  imdbGraph graph;
+  size_t actorFileSize = db.getFileSize(imdb::ACTOR), movieFileSize = db.getFileSize(imdb::MOVIE);
+  if (!graph.load(directory + "/graphdata", actorFileSize, movieFileSize, db.getDataStamp())) {
+    cerr << "Couldn't reload the graph snapshot.  Aborting..." << endl;
+    return 1;
+  }
+  long edges = costarGraph::write(directory + "/costardata", graph, actorFileSize, movieFileSize,
+				  db.getDataStamp());
+  if (edges == -1) {
+    cerr << "Couldn't write the co-star adjacency.  Aborting..." << endl;
+    return 1;
+  }
+  cout << "Wrote " << edges << " co-star edges." << endl;
+  return 0;
+}
@@ -0,0 +1,60 @@
+#include <vector>
+#include <string>
+#include <iostream>
+#include "imdb.h"
+#include "name-index.h"
+#include "suggest-index.h"
+using namespace std;
+
+/**
+ * Function: main
+ * --------------
+ * Builds the actorindex and movieindex sidecar files for the data files
+ * in the specified directory (see nameIndex), writing them alongside
+ * the data.  Every imdb constructed over that directory afterwards will
+ * use them for constant-time name lookup.  The actorsuggest sidecar, for
+ * prefix and approximate name search (see suggestIndex), is written too.
+ *
+ * Usage: build-index [data-directory]
+ */
+
+int main(int argc, const char *argv[])
+{
+  string directory = determinePathToData(argc > 1 ? argv[1] : NULL);
+  imdb db(directory);
+  if (!db.good()) { cerr << db.getLoadErrorMessage() << "  Aborting..." << endl; return 1; }
+
+  vector<uint64_t> hashes;
+  vector<int> records;
+  for (int i = 0; i < db.getNumActors(); i++) {
+    records.push_back(db.getActorRecordAt(i));
+    hashes.push_back(nameIndex::hashActor(db.getActorName(records.back()).c_str()));
+  }
+  if (!nameIndex::write(directory + "/actorindex", hashes, records, db.getFileSize(imdb::ACTOR),
+			db.getDataStamp())) {
+    cerr << "Couldn't write the actor index.  Aborting..." << endl;
+    return 1;
+  }
+  cout << "Indexed " << records.size() << " actors." << endl;
+
+  hashes.clear();
+  records.clear();
+  for (int i = 0; i < db.getNumMovies(); i++) {
+    records.push_back(db.getMovieRecordAt(i));
+    film movie = db.getMovie(records.back());
+    hashes.push_back(nameIndex::hashMovie(movie.title.c_str(), movie.year));
+  }
+  if (!nameIndex::write(directory + "/movieindex", hashes, records, db.getFileSize(imdb::MOVIE),
+			db.getDataStamp())) {
+    cerr << "Couldn't write the movie index.  Aborting..." << endl;
+    return 1;
+  }
+  cout << "Indexed " << records.size() << " movies." << endl;
+
+  if (!suggestIndex::write(directory + "/actorsuggest", db)) {
+    cerr << "Couldn't write the actor name suggestions.  Aborting..." << endl;
+    return 1;
+  }
+  cout << "Wrote name suggestions for " << db.getNumActors() << " actors." << endl;
+  return 0;
+}
@@ -0,0 +1,53 @@
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <sys/resource.h>
+#include "imdb.h"
+#include "distance-oracle.h"
+using namespace std;
+
+/**
+ * Function: main
+ * --------------
+ * Builds the pruned landmark labelling (see distanceOracle) of the actor
+ * graph in the specified directory and writes it alongside the data files
+ * as labeldata, where every imdb constructed afterwards picks it up.  The
+ * graph snapshot must already exist (see build-graph); the co-star adjacency
+ * is used too, if it's there, and makes the build considerably faster.
+ *
+ * Once the file is written, a short report of what the build cost is
+ * printed: time, peak memory, and the size of the labels.
+ *
+ * Usage: build-labels [data-directory]
+ */
+
+int main(int argc, const char *argv[])
+{
+  string directory = determinePathToData(argc > 1 ? argv[1] : NULL);
+  imdb db(directory);
+  if (!db.good()) { cerr << db.getLoadErrorMessage() << "  Aborting..." << endl; return 1; }
+  const imdbGraph *graph = db.getGraph();
+  if (graph == NULL) { cerr << "No graph snapshot; run build-graph first.  Aborting..." << endl; return 1; }
+
+  distanceOracle::buildReport report;
+  if (!distanceOracle::build(directory + "/labeldata", *graph, db.getCostarGraph(),
+			     db.getFileSize(imdb::ACTOR), db.getFileSize(imdb::MOVIE), db.getDataStamp(),
+			     report)) {
+    cerr << "Couldn't write the labelling.  Aborting..." << endl;
+    return 1;
+  }
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  int actors = graph->getNumActors();
+  cout << "Labelled " << actors << " actors"
+       << (db.getCostarGraph() != NULL ? " (using the co-star adjacency)." : ".") << endl;
+  cout << fixed << setprecision(2);
+  cout << "  build time:      " << report.seconds << " s" << endl;
+  cout << "  peak memory:     " << usage.ru_maxrss / 1024.0 << " MB" << endl;
+  cout << "  label entries:   " << report.entries << endl;
+  cout << "  average label:   " << (actors == 0 ? 0.0 : (double) report.entries / actors) << endl;
+  cout << "  longest label:   " << report.maxLabelSize << endl;
+  cout << "  file size:       " << report.fileSize / (1024.0 * 1024.0) << " MB" << endl;
+  return 0;
+}
@@ -0,0 +1,60 @@
+#include "cached_imdb.h"
+using namespace std;
+
+/**
+ * Rough per-entry bookkeeping cost (list node, hash node, shared_ptr
+ * control block), charged on top of the strings each entry holds.
+ */
+
+static const size_t kEntryOverhead = 96;
+
+static size_t bytesFor(const string& s)
+{
+  return sizeof(string) + s.capacity();
+}
+
+static size_t bytesFor(const film& movie)
+{
+  return sizeof(film) + movie.title.capacity();
+}
+
+cached_imdb::cached_imdb(const string& directory, size_t memoryBudget, int numShards,
+			 int mapOptions) :
+  imdb(directory, mapOptions),
+  actorCache(memoryBudget / 2, numShards),
+  movieCache(memoryBudget / 2, numShards) {}
+
+/**
+ * Players who aren't in the database aren't cached; every lookup of
+ * a missing player goes through to the imdb.
+ */
+
+bool cached_imdb::getCredits(const string& player, vector<film>& films) const
+{
+  shared_ptr<const vector<film> > cached = actorCache.lookup(player);
+  if (cached == NULL) {
+    shared_ptr<vector<film> > credits(new vector<film>);
+    if (!imdb::getCredits(player, *credits)) return false;
+    size_t bytes = kEntryOverhead + bytesFor(player);
+    for (size_t i = 0; i < credits->size(); i++) bytes += bytesFor((*credits)[i]);
+    actorCache.insert(player, credits, bytes);
+    cached = credits;
+  }
+  films.insert(films.end(), cached->begin(), cached->end());
+  return true;
+}
+
+bool cached_imdb::getCast(const film& movie, vector<string>& players) const
+{
+  shared_ptr<const vector<string> > cached = movieCache.lookup(movie);
+  if (cached == NULL) {
+    shared_ptr<vector<string> > cast(new vector<string>);
+    if (!imdb::getCast(movie, *cast)) return false;
+    size_t bytes = kEntryOverhead + bytesFor(movie);
+    for (size_t i = 0; i < cast->size(); i++) bytes += bytesFor((*cast)[i]);
+    movieCache.insert(movie, cast, bytes);
+    cached = cast;
+  }
+  players.insert(players.end(), cached->begin(), cached->end());
+  return true;
+}
@@ -1,31 +1,76 @@
-#ifndef cached_imdb
-#define cached_imdb
+#ifndef __cached_imdb__
+#define __cached_imdb__
 
 #include "imdb.h"
 #include "imdb-utils.h"
-#include <map>
+#include "lru-cache.h"
 
 using namespace std;
 
+/**
+ * Class: cached_imdb
+ * ------------------
+ * An imdb that remembers the results of recent getCredits and getCast
+ * calls, so that the credits of hub actors and the casts of blockbusters
+ * are decoded once rather than on every query.  The cache is bounded by a
+ * memory budget, evicts least recently used entries first, and is sharded
+ * so several query threads can share one cached_imdb.
+ *
+ * getCredits and getCast are virtual in imdb, so a cached_imdb can be handed
+ * to anything expecting an imdb (the search engines, for instance).
+ */
+
 class cached_imdb: public imdb {
  public:
-  cached_imdb(const string& directory){
-    actorCache = map<string, vector<film> >();
-    movieCache = map<film, vector<string> >();
-  } 
-
-  bool getCredits(const string& player, vector<film>& films) const{
-    map<player, vector<film> >::iterator found actorCache.find(player);
-    if (found == actorCache.end()){
-      bool returnVal = imdb::getCredits(player, films);
-      if (returnVal) actorCache[player] = films;
-	return returnVal;
-    } else 
-  }
+  static const size_t kDefaultMemoryBudget = 64 << 20;
+  static const int kDefaultNumShards = 16;
+
+  /**
+   * Constructor: cached_imdb
+   * ------------------------
+   * Constructs an imdb over the specified directory, exactly as imdb's constructor
+   * does, with empty caches in front of it.
+   *
+   * @param directory the name of the directory housing the data files.
+   * @param memoryBudget the approximate number of bytes the cached credits and
+   *                     casts may occupy, split evenly between the two.
+   * @param numShards the number of independently locked shards in each cache.
+   * @param mapOptions how the data files are mapped (see imdb's constructor).
+   */
+
+  cached_imdb(const string& directory, size_t memoryBudget = kDefaultMemoryBudget,
+	      int numShards = kDefaultNumShards, int mapOptions = 0);
+
+  /**
+   * Methods: getCredits
+   *          getCast
+   * ------------------
+   * Same contract as imdb's, but answered from the cache when possible.
+   * The zero-copy overloads aren't cached, since they copy nothing anyway.
+   */
+
+  using imdb::getCredits;
+  using imdb::getCast;
+  bool getCredits(const string& player, vector<film>& films) const;
+  bool getCast(const film& movie, vector<string>& players) const;
+
+  /**
+   * Methods: getCreditStats
+   *          getCastStats
+   * -----------------------
+   * Return the hit, miss, and eviction counters of the two caches.
+   */
+
+  cacheStats getCreditStats() const { return actorCache.getStats(); }
+  cacheStats getCastStats() const { return movieCache.getStats(); }
+
  private:
-  map<string, vector<film> > actorCache;
-  map<film, vector<string> > movieCache;
+  struct filmHash {
+    size_t operator()(const film& movie) const { return hash<string>()(movie.title) * 31 + movie.year; }
+  };
 
+  mutable lruCache<string, vector<film> > actorCache;
+  mutable lruCache<film, vector<string>, filmHash> movieCache;
 };
 
 
@@ -0,0 +1,95 @@
+#include <vector>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include "imdb.h"
+#include "data-format.h"
+using namespace std;
+
+/**
+ * Function: legacyOrderFits
+ * -------------------------
+ * Returns true if the specified legacy data file reads sensibly in native
+ * byte order (or, if swapped is true, in the foreign one): its record count
+ * leaves room for the offset table, and the first record lies past it.
+ */
+
+static bool legacyOrderFits(const vector<char>& data, bool swapped)
+{
+  if (data.size() < 2 * sizeof(uint32_t)) return false;
+  uint32_t count, first;
+  memcpy(&count, &data[0], sizeof(count));
+  memcpy(&first, &data[sizeof(count)], sizeof(first));
+  if (swapped) {
+    count = __builtin_bswap32(count);
+    first = __builtin_bswap32(first);
+  }
+  size_t recordsStart = sizeof(uint32_t) * (1 + (size_t) count);
+  return count > 0 && recordsStart <= data.size() && first >= recordsStart && first < data.size();
+}
+
+/**
+ * Function: convertFile
+ * ---------------------
+ * Reads the named legacy data file, in either byte order, and writes it to
+ * destination as a canonical data file.
+ *
+ * @return false, after explaining why on cerr, if the conversion failed.
+ */
+
+static bool convertFile(const string& source, const string& destination, int type)
+{
+  ifstream in(source.c_str(), ios::binary);
+  if (!in) { cerr << "Couldn't open " << source << "." << endl; return false; }
+  vector<char> data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+  if (data.size() >= sizeof(kDataMagic) && memcmp(&data[0], kDataMagic, sizeof(kDataMagic)) == 0) {
+    cerr << source << " is already in the canonical format." << endl;
+    return false;
+  }
+
+  if (!legacyOrderFits(data, false)) {
+    if (!legacyOrderFits(data, true) || !swapDataFile(&data[0], data.size(), type, true)) {
+      cerr << source << " doesn't look like a data file in either byte order." << endl;
+      return false;
+    }
+    cout << source << " is in the foreign byte order; swapped it." << endl;
+  }
+  if (!writeCanonicalDataFile(destination, &data[0], data.size(), type)) {
+    cerr << "Couldn't write " << destination << "." << endl;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Function: main
+ * --------------
+ * Converts the legacy actordata and moviedata files in the source directory,
+ * whichever byte order they were written in, into canonical data files (see
+ * data-format.h) in the destination directory, and then opens the result to
+ * validate it.  The one canonical copy can be read on any machine, so it
+ * replaces both the little-endian and the big-endian trees.  Sidecars such as
+ * the name index and graph snapshot have to be rebuilt in the destination.
+ *
+ * Usage: convert-data [source-directory] destination-directory
+ */
+
+int main(int argc, const char *argv[])
+{
+  if (argc < 2) {
+    cerr << "Usage: convert-data [source-directory] destination-directory" << endl;
+    return 1;
+  }
+  string source = determinePathToData(argc > 2 ? argv[1] : NULL);
+  string destination = argv[argc - 1];
+  if (!convertFile(source + "/actordata", destination + "/actordata", imdb::ACTOR) ||
+      !convertFile(source + "/moviedata", destination + "/moviedata", imdb::MOVIE))
+    return 1;
+
+  imdb db(destination);
+  if (!db.good()) { cerr << db.getLoadErrorMessage() << "  Aborting..." << endl; return 1; }
+  cout << "Wrote canonical data for " << db.getNumActors() << " actors and "
+       << db.getNumMovies() << " movies to " << destination << "." << endl;
+  return 0;
+}
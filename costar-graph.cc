@@ -0,0 +1,94 @@
+using namespace std;
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <vector>
+#include "costar-graph.h"
+#include "imdb-graph.h"
+
+costarGraph::costarGraph() :
+  fileMap(NULL), fileSize(0), numActors(0), costarStart(NULL), costars(NULL), witnesses(NULL) {}
+
+bool costarGraph::load(const string& fileName, size_t actorFileSize, size_t movieFileSize,
+		       const dataStamp& stamp)
+{
+  int fd = open(fileName.c_str(), O_RDONLY);
+  if (fd == -1) return false;
+  struct stat stats;
+  if (fstat(fd, &stats) == -1 || stats.st_size < (off_t) (kHeaderInts * sizeof(int))) {
+    close(fd);
+    return false;
+  }
+  void *map = mmap(0, stats.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) return false;
+
+  const int *header = (const int *) map;
+  size_t actors = header[4], edges = header[5];
+  size_t expectedSize = (kHeaderInts + actors + 1 + 2 * edges) * sizeof(int);
+  if (header[0] != kMagic || header[1] != kVersion || header[2] != (int) actorFileSize ||
+      header[3] != (int) movieFileSize || expectedSize != (size_t) stats.st_size ||
+      !stamp.matches(header + kStampAt)) {
+    munmap(map, stats.st_size);
+    return false;
+  }
+
+  fileMap = map;
+  fileSize = stats.st_size;
+  numActors = actors;
+  costarStart = header + kHeaderInts;
+  costars = costarStart + actors + 1;
+  witnesses = costars + edges;
+  return true;
+}
+
+/**
+ * Each actor's co-stars are gathered by walking the casts of its credits,
+ * with a per-actor stamp deduplicating co-stars met in more than one movie;
+ * the first movie they were met in becomes the witness.
+ */
+
+long costarGraph::write(const string& fileName, const imdbGraph& graph,
+			size_t actorFileSize, size_t movieFileSize, const dataStamp& filesStamp)
+{
+  int actors = graph.getNumActors();
+  vector<int> costarStart(1, 0), costars, witnesses;
+  vector<int> stamp(actors, -1);
+  for (int a = 0; a < actors; a++) {
+    stamp[a] = a;
+    const int *movies;
+    int numMovies = graph.getCredits(a, movies);
+    for (int j = 0; j < numMovies; j++) {
+      const int *cast;
+      int castSize = graph.getCast(movies[j], cast);
+      for (int k = 0; k < castSize; k++) {
+	if (stamp[cast[k]] == a) continue;
+	stamp[cast[k]] = a;
+	costars.push_back(cast[k]);
+	witnesses.push_back(movies[j]);
+      }
+    }
+    costarStart.push_back(costars.size());
+  }
+
+  FILE *out = fopen(fileName.c_str(), "wb");
+  if (out == NULL) return -1;
+  int header[kHeaderInts] = {
+    kMagic, kVersion, (int) actorFileSize, (int) movieFileSize, actors, (int) costars.size()
+  };
+  filesStamp.store(header + kStampAt);
+  bool ok = fwrite(header, sizeof(int), kHeaderInts, out) == (size_t) kHeaderInts &&
+    fwrite(&costarStart[0], sizeof(int), costarStart.size(), out) == costarStart.size() &&
+    fwrite(costars.data(), sizeof(int), costars.size(), out) == costars.size() &&
+    fwrite(witnesses.data(), sizeof(int), witnesses.size(), out) == witnesses.size();
+  if (fclose(out) != 0 || !ok) return -1;
+  return costars.size();
+}
+
+costarGraph::~costarGraph()
+{
+  if (fileMap != NULL) munmap((char *) fileMap, fileSize);
+}
@@ -0,0 +1,108 @@
+#ifndef __costar_graph__
+#define __costar_graph__
+
+#include <string>
+#include "data-format.h"
+using namespace std;
+
+class imdbGraph;
+
+/**
+ * Class: costarGraph
+ * ------------------
+ * A precomputed, deduplicated actor-to-co-star adjacency, kept in a sidecar
+ * file named costardata and built from an imdbGraph (so actor and movie IDs
+ * are the graph's dense IDs).  Each edge carries one witness movie both actors
+ * appeared in, which is all a path needs to name the connection.  A search
+ * over it goes straight from actor to co-star, without expanding any casts.
+ *
+ * The file layout, all native-endian 32-bit ints, is
+ *
+ *     magic, version, actor file size, movie file size,
+ *     number of actors, number of edges,
+ *     data stamp[dataStamp::kInts] (see data-format.h),
+ *     costarStart[actors + 1]  the co-stars of actor a are
+ *                              costars[costarStart[a] .. costarStart[a + 1])
+ *     costars[edges]           actor IDs
+ *     witnesses[edges]         movie IDs, parallel to costars
+ *
+ * Every co-star relationship is stored in both directions.
+ */
+
+class costarGraph {
+ public:
+
+  /**
+   * Constructor: costarGraph
+   * ------------------------
+   * Constructs an adjacency with nothing loaded; good() returns false
+   * until load succeeds.
+   */
+
+  costarGraph();
+
+  /**
+   * Method: load
+   * ------------
+   * Maps the named sidecar into memory, provided it exists, is well formed,
+   * and was built from data files of the specified sizes and stamp.
+   *
+   * @return true if and only if the adjacency is now ready for use.
+   */
+
+  bool load(const string& fileName, size_t actorFileSize, size_t movieFileSize,
+	    const dataStamp& stamp);
+
+  bool good() const { return fileMap != NULL; }
+  int getNumActors() const { return numActors; }
+
+  /**
+   * Method: getCostars
+   * ------------------
+   * Sets costars to the base of the run of IDs of the specified actor's
+   * co-stars, and witnesses to the parallel run of movie IDs linking them.
+   *
+   * @return the length of the two runs.
+   */
+
+  int getCostars(int actor, const int *& costars, const int *& witnesses) const {
+    costars = this->costars + costarStart[actor];
+    witnesses = this->witnesses + costarStart[actor];
+    return costarStart[actor + 1] - costarStart[actor];
+  }
+
+  /**
+   * Method: write
+   * -------------
+   * Builds the co-star adjacency of the specified graph and writes it to
+   * the named file.
+   *
+   * @param actorFileSize/movieFileSize the sizes of the data files the
+   *                                    graph was built from.
+   * @param filesStamp the stamp of those data files.
+   * @return the number of edges written, or -1 if the file couldn't be written.
+   */
+
+  static long write(const string& fileName, const imdbGraph& graph,
+		    size_t actorFileSize, size_t movieFileSize, const dataStamp& filesStamp);
+
+  ~costarGraph();
+
+ private:
+  static const int kMagic = 0x72617463; // "ctar"
+  static const int kVersion = 2;
+  static const int kStampAt = 6;
+  static const int kHeaderInts = kStampAt + dataStamp::kInts;
+
+  const void *fileMap;
+  size_t fileSize;
+  int numActors;
+  const int *costarStart;
+  const int *costars;
+  const int *witnesses;
+
+  costarGraph(const costarGraph& original);
+  costarGraph& operator=(const costarGraph& rhs);
+};
+
+#endif
@@ -0,0 +1,102 @@
+using namespace std;
+#include <cassert>
+#include <cstring>
+#include <cstdio>
+#include <vector>
+#include "data-format.h"
+#include "imdb.h"
+
+size_t getShortPadding(int type, size_t nameLength){
+  size_t padding;
+  if(type == imdb::ACTOR){
+    if(nameLength % 2 == 1) padding = 1;
+    else padding = 2;
+  } else if(type == imdb::MOVIE){
+    if(nameLength % 2 == 1) padding = 3;
+    else padding = 2;
+  } else {
+    assert(type == imdb::ACTOR || type == imdb::MOVIE);
+  }
+  return padding;
+}
+
+/**
+ * Reverse the bytes of the 32-bit (or 16-bit) field at the specified address,
+ * and return the field's value in native order: its value after the swap if
+ * it's being converted to native order, and before the swap otherwise.
+ */
+
+static int32_t swapInt(char *at, bool toNative)
+{
+  uint32_t value;
+  memcpy(&value, at, sizeof(value));
+  uint32_t swapped = __builtin_bswap32(value);
+  memcpy(at, &swapped, sizeof(swapped));
+  return toNative ? swapped : value;
+}
+
+static int16_t swapShort(char *at, bool toNative)
+{
+  uint16_t value;
+  memcpy(&value, at, sizeof(value));
+  uint16_t swapped = __builtin_bswap16(value);
+  memcpy(at, &swapped, sizeof(swapped));
+  return toNative ? swapped : value;
+}
+
+bool swapDataFile(char *data, size_t size, int type, bool toNative)
+{
+  if (size < sizeof(int32_t)) return false;
+  int32_t numRecords = swapInt(data, toNative);
+  size_t recordsStart = sizeof(int32_t) * (1 + (size_t) numRecords);
+  if (numRecords < 0 || recordsStart > size) return false;
+  for (int32_t i = 0; i < numRecords; i++) {
+    int32_t offset = swapInt(data + sizeof(int32_t) * (1 + i), toNative);
+    if (offset < (long) recordsStart || (size_t) offset >= size) return false;
+    const char *name = data + offset;
+    const char *end = (const char *) memchr(name, '\0', size - offset);
+    if (end == NULL) return false;
+    size_t countAt = offset + (end - name) + getShortPadding(type, end - name);
+    if (countAt + sizeof(int16_t) > size) return false;
+    int16_t count = swapShort(data + countAt, toNative);
+    size_t arrayAt = countAt + sizeof(int16_t);
+    if ((arrayAt - offset) % 4 != 0) arrayAt += 2;
+    if (count < 0 || arrayAt + count * sizeof(int32_t) > size) return false;
+    for (int16_t j = 0; j < count; j++) swapInt(data + arrayAt + j * sizeof(int32_t), toNative);
+  }
+  return true;
+}
+
+/**
+ * On a little-endian machine the payload is written straight out; anywhere
+ * else a copy is swapped to little-endian order first.
+ */
+
+bool writeCanonicalDataFile(const string& fileName, const char *data, size_t size, int type)
+{
+  if (size < sizeof(int32_t)) return false;
+  dataFileHeader header;
+  memcpy(header.magic, kDataMagic, sizeof(header.magic));
+  header.version = kDataVersion;
+  header.byteOrder = kByteOrderMark;
+  header.type = type;
+  memcpy(&header.numRecords, data, sizeof(header.numRecords));
+  header.payloadSize = size;
+
+  vector<char> swapped;
+  if (!kNativeLittleEndian) {
+    swapped.assign(data, data + size);
+    if (!swapDataFile(&swapped[0], size, type, false)) return false;
+    data = &swapped[0];
+    header.version = __builtin_bswap32(header.version);
+    header.byteOrder = __builtin_bswap32(header.byteOrder);
+    header.type = __builtin_bswap32(header.type);
+    header.numRecords = __builtin_bswap32(header.numRecords);
+    header.payloadSize = __builtin_bswap64(header.payloadSize);
+  }
+
+  FILE *out = fopen(fileName.c_str(), "wb");
+  if (out == NULL) return false;
+  bool ok = fwrite(&header, sizeof(header), 1, out) == 1 && fwrite(data, 1, size, out) == size;
+  return fclose(out) == 0 && ok;
+}
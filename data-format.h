@@ -0,0 +1,146 @@
+#ifndef __data_format__
+#define __data_format__
+
+#include <string>
+#include <cstring>
+#include <stdint.h>
+using namespace std;
+
+/**
+ * The canonical data format
+ * -------------------------
+ * The original actordata and moviedata files carry no header and are written
+ * in the byte order of whichever machine is to read them, so a little-endian
+ * and a big-endian copy of the whole dataset have to be kept side by side.
+ * A canonical data file is one of those files, always in little-endian order,
+ * preceded by a dataFileHeader.  The records themselves are unchanged, and
+ * every record offset is still measured from the start of the payload (the
+ * byte just past the header), so an imdb simply maps the file and points past
+ * the header.  Nothing is ever swapped at load time: every count and offset
+ * the imdb reads from a payload goes through readLittleInt or readLittleShort
+ * (or an offsetArray), which compile to plain loads on little-endian machines
+ * and to loads and byte swaps on big-endian ones.  Legacy files, whose byte
+ * order can only be guessed at, are read by little-endian builds alone.
+ *
+ * The header's byteOrder field holds kByteOrderMark in little-endian order,
+ * as a check that the file really was written as one.  The sidecar files
+ * built from a canonical file (see build-index and build-graph) stay in
+ * native order.
+ */
+
+struct dataFileHeader {
+  char magic[8];        /// kDataMagic, so a canonical file is never mistaken for a legacy one
+  uint32_t version;     /// kDataVersion
+  uint32_t byteOrder;   /// kByteOrderMark, in the byte order of the payload
+  uint32_t type;        /// imdb::ACTOR or imdb::MOVIE
+  uint32_t numRecords;  /// the number of records in the payload's offset table
+  uint64_t payloadSize; /// the size of everything past the header, in bytes
+};
+
+static const char kDataMagic[8] = { 'I', 'M', 'D', 'B', 'D', 'A', 'T', 'A' };
+static const uint32_t kDataVersion = 1;
+static const uint32_t kByteOrderMark = 0x01020304;
+static const bool kNativeLittleEndian = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+
+/**
+ * Functions: readLittleInt
+ *            readLittleShort
+ * --------------------------
+ * Read one 32-bit (or 16-bit) little-endian field of a data file payload.
+ */
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+inline int32_t readLittleInt(const void *at) { return *(const int32_t *) at; }
+inline int16_t readLittleShort(const void *at) { return *(const int16_t *) at; }
+#else
+inline int32_t readLittleInt(const void *at) { return __builtin_bswap32(*(const uint32_t *) at); }
+inline int16_t readLittleShort(const void *at) { return __builtin_bswap16(*(const uint16_t *) at); }
+#endif
+
+/**
+ * Type: offsetArray
+ * -----------------
+ * The offset array stored inside a record, as handed out by
+ * imdb::getCreditRecords and getCastRecords.  On little-endian machines it's
+ * a plain pointer into the mapped file; on big-endian ones, a wrapper whose
+ * indexing reads each element with readLittleInt.  Either way, clients only
+ * ever index it.
+ */
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+typedef const int *offsetArray;
+#else
+class offsetArray {
+ public:
+  offsetArray(const int *base = NULL) : base(base) {}
+  int operator[](size_t i) const { return readLittleInt(base + i); }
+
+ private:
+  const int *base;
+};
+#endif
+
+/**
+ * Convenience struct: dataStamp
+ * -----------------------------
+ * Identifies one pair of data files: the size and modification time of each,
+ * and an FNV-1a checksum of their offset tables.  An imdb computes the stamp
+ * of the files it opens while validating them (see imdb::getDataStamp), and
+ * every sidecar records the stamp of the files it was built from at the end
+ * of its header, taking up kInts ints there.  A sidecar whose stamp doesn't
+ * match is never loaded, even if the data files it was built from were the
+ * same size as the ones it sits next to now.
+ */
+
+struct dataStamp {
+  static const int kWords = 8;
+  static const int kInts = kWords * sizeof(uint64_t) / sizeof(int);
+  uint64_t words[kWords];
+
+  void store(int *header) const { memcpy(header, words, sizeof(words)); }
+  bool matches(const int *header) const { return memcmp(header, words, sizeof(words)) == 0; }
+};
+
+/**
+ * Function: getShortPadding
+ * -------------------------
+ * Returns the number of bytes between the end of a record's name and its
+ * short count of offsets: the name's terminator (and, for a movie, the year
+ * byte) plus whatever padding brings the count to an even offset.
+ *
+ * @param type imdb::ACTOR or imdb::MOVIE.
+ * @param nameLength the length of the record's name or title.
+ */
+
+size_t getShortPadding(int type, size_t nameLength);
+
+/**
+ * Function: swapDataFile
+ * ----------------------
+ * Reverses the byte order of every multi-byte field of the specified data
+ * file payload, in place: the record count, the offset table, and each
+ * record's count and offset array.  Names and years are single bytes and are
+ * left alone.  Every offset is checked before it's followed.
+ *
+ * @param data the payload (a legacy file, or a canonical file past its header).
+ * @param size the size of the payload.
+ * @param type imdb::ACTOR or imdb::MOVIE.
+ * @param toNative true if data is in the foreign byte order and is being
+ *                 converted to the native one, false if the reverse.
+ * @return false if the payload turned out to be malformed part way through.
+ */
+
+bool swapDataFile(char *data, size_t size, int type, bool toNative);
+
+/**
+ * Function: writeCanonicalDataFile
+ * --------------------------------
+ * Writes the specified payload, in native byte order, to the named file as a
+ * canonical data file: a header followed by the payload in little-endian order.
+ *
+ * @return true if and only if the file was written successfully.
+ */
+
+bool writeCanonicalDataFile(const string& fileName, const char *data, size_t size, int type);
+
+#endif
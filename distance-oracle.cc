@@ -0,0 +1,188 @@
+using namespace std;
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+#include "distance-oracle.h"
+#include "imdb-graph.h"
+#include "costar-graph.h"
+#include "imdb-utils.h"
+
+distanceOracle::distanceOracle() :
+  fileMap(NULL), fileSize(0), numActors(0), labelStart(NULL), hubs(NULL), distances(NULL) {}
+
+bool distanceOracle::load(const string& fileName, size_t actorFileSize, size_t movieFileSize,
+			  const dataStamp& stamp)
+{
+  int fd = open(fileName.c_str(), O_RDONLY);
+  if (fd == -1) return false;
+  struct stat stats;
+  if (fstat(fd, &stats) == -1 || stats.st_size < (off_t) (kHeaderInts * sizeof(int))) {
+    close(fd);
+    return false;
+  }
+  void *map = mmap(0, stats.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) return false;
+
+  const int *header = (const int *) map;
+  size_t actors = header[4], entries = header[5];
+  size_t expectedSize = (kHeaderInts + actors + 1 + entries) * sizeof(int) + entries;
+  if (header[0] != kMagic || header[1] != kVersion || header[2] != (int) actorFileSize ||
+      header[3] != (int) movieFileSize || expectedSize != (size_t) stats.st_size ||
+      !stamp.matches(header + kStampAt)) {
+    munmap(map, stats.st_size);
+    return false;
+  }
+
+  fileMap = map;
+  fileSize = stats.st_size;
+  numActors = actors;
+  labelStart = header + kHeaderInts;
+  hubs = labelStart + actors + 1;
+  distances = (const uint8_t *) (hubs + entries);
+  return true;
+}
+
+/**
+ * Both labels are sorted by hub, so the shared hubs turn up in a single
+ * merge-style pass over the two.
+ */
+
+int distanceOracle::getDistance(int actor, int other) const
+{
+  int i = labelStart[actor], iEnd = labelStart[actor + 1];
+  int j = labelStart[other], jEnd = labelStart[other + 1];
+  int best = -1;
+  while (i < iEnd && j < jEnd) {
+    if (hubs[i] < hubs[j]) i++;
+    else if (hubs[i] > hubs[j]) j++;
+    else {
+      int d = distances[i++] + distances[j++];
+      if (best == -1 || d < best) best = d;
+    }
+  }
+  return best;
+}
+
+/**
+ * Appends the neighbours of the specified actor to neighbours.  Without a
+ * co-star adjacency the same co-star may be appended more than once; the
+ * breadth-first searches that consume the list ignore the repeats.
+ */
+
+static void appendNeighbours(int actor, const imdbGraph& graph, const costarGraph *costars,
+			     vector<int>& neighbours)
+{
+  if (costars != NULL) {
+    const int *ids, *witnesses;
+    int count = costars->getCostars(actor, ids, witnesses);
+    neighbours.insert(neighbours.end(), ids, ids + count);
+    return;
+  }
+  const int *movies;
+  int numMovies = graph.getCredits(actor, movies);
+  for (int j = 0; j < numMovies; j++) {
+    const int *cast;
+    int castSize = graph.getCast(movies[j], cast);
+    neighbours.insert(neighbours.end(), cast, cast + castSize);
+  }
+}
+
+/**
+ * The labelling is built the usual way: one breadth-first search per actor,
+ * most central first, each adding its root as a hub to the label of every actor
+ * it reaches, except that the search is pruned at any actor whose distance
+ * to the root the labels built so far already answer correctly.  Later
+ * searches are pruned almost immediately, which is what keeps labels short.
+ */
+
+bool distanceOracle::build(const string& fileName, const imdbGraph& graph, const costarGraph *costars,
+			   size_t actorFileSize, size_t movieFileSize, const dataStamp& stamp,
+			   buildReport& report)
+{
+  const uint8_t kUnreached = 255;
+  double start = monotonicSeconds();
+  int actors = graph.getNumActors();
+
+  vector<pair<long, int> > order; // (-degree, actor)
+  vector<int> neighbours;
+  for (int a = 0; a < actors; a++) {
+    neighbours.clear();
+    appendNeighbours(a, graph, costars, neighbours);
+    order.push_back(make_pair(-(long) neighbours.size(), a));
+  }
+  sort(order.begin(), order.end());
+
+  vector<vector<int> > labelHubs(actors);
+  vector<vector<uint8_t> > labelDistances(actors);
+  vector<uint8_t> distance(actors, kUnreached);
+  vector<uint8_t> rootDistance(actors, kUnreached); // indexed by hub
+  vector<int> queue;
+  for (int rank = 0; rank < actors; rank++) {
+    int root = order[rank].second;
+    for (size_t k = 0; k < labelHubs[root].size(); k++)
+      rootDistance[labelHubs[root][k]] = labelDistances[root][k];
+
+    queue.clear();
+    queue.push_back(root);
+    distance[root] = 0;
+    for (size_t head = 0; head < queue.size(); head++) {
+      int actor = queue[head];
+      int d = distance[actor];
+      bool pruned = false;
+      for (size_t k = 0; k < labelHubs[actor].size() && !pruned; k++) {
+	uint8_t viaHub = rootDistance[labelHubs[actor][k]];
+	pruned = viaHub != kUnreached && viaHub + labelDistances[actor][k] <= d;
+      }
+      if (pruned) continue;
+      labelHubs[actor].push_back(rank);
+      labelDistances[actor].push_back(d);
+      if (d + 1 >= kUnreached) continue;
+
+      neighbours.clear();
+      appendNeighbours(actor, graph, costars, neighbours);
+      for (size_t k = 0; k < neighbours.size(); k++) {
+	if (distance[neighbours[k]] != kUnreached) continue;
+	distance[neighbours[k]] = d + 1;
+	queue.push_back(neighbours[k]);
+      }
+    }
+
+    for (size_t k = 0; k < queue.size(); k++) distance[queue[k]] = kUnreached;
+    for (size_t k = 0; k < labelHubs[root].size(); k++) rootDistance[labelHubs[root][k]] = kUnreached;
+  }
+
+  vector<int> labelStart(1, 0);
+  report.maxLabelSize = 0;
+  for (int a = 0; a < actors; a++) {
+    labelStart.push_back(labelStart.back() + labelHubs[a].size());
+    report.maxLabelSize = max(report.maxLabelSize, (int) labelHubs[a].size());
+  }
+  report.entries = labelStart.back();
+  report.seconds = monotonicSeconds() - start;
+
+  FILE *out = fopen(fileName.c_str(), "wb");
+  if (out == NULL) return false;
+  int header[kHeaderInts] = {
+    kMagic, kVersion, (int) actorFileSize, (int) movieFileSize, actors, (int) report.entries
+  };
+  stamp.store(header + kStampAt);
+  bool ok = fwrite(header, sizeof(int), kHeaderInts, out) == (size_t) kHeaderInts &&
+    fwrite(&labelStart[0], sizeof(int), labelStart.size(), out) == labelStart.size();
+  for (int a = 0; a < actors && ok; a++)
+    ok = fwrite(labelHubs[a].data(), sizeof(int), labelHubs[a].size(), out) == labelHubs[a].size();
+  for (int a = 0; a < actors && ok; a++)
+    ok = fwrite(labelDistances[a].data(), 1, labelDistances[a].size(), out) == labelDistances[a].size();
+  report.fileSize = ok ? ftell(out) : 0;
+  return fclose(out) == 0 && ok;
+}
+
+distanceOracle::~distanceOracle()
+{
+  if (fileMap != NULL) munmap((char *) fileMap, fileSize);
+}
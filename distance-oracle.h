@@ -0,0 +1,116 @@
+#ifndef __distance_oracle__
+#define __distance_oracle__
+
+#include <string>
+#include <stdint.h>
+#include "data-format.h"
+using namespace std;
+
+class imdbGraph;
+class costarGraph;
+
+/**
+ * Class: distanceOracle
+ * ---------------------
+ * A pruned landmark labelling (a 2-hop cover) of the actor graph, kept in a
+ * sidecar file named labeldata and built from an imdbGraph, so it uses the
+ * graph's dense actor IDs.  Every actor carries a label: a list of (hub, distance)
+ * pairs, sorted by hub, such that for any two actors some hub on a shortest path
+ * between them appears in both labels.  The distance between two actors is then
+ * the smallest sum of distances over the hubs their labels share, found by one
+ * merge of two short sorted lists; no search is run at all.
+ *
+ * Hubs are numbered by rank: actors are processed in decreasing order of
+ * degree, and the most central actors end up in almost every label.
+ *
+ * The file layout, all native-endian, is a header of kHeaderInts 32-bit ints
+ *
+ *     magic, version, actor file size, movie file size,
+ *     number of actors, number of label entries,
+ *     data stamp[dataStamp::kInts] (see data-format.h)
+ *
+ * followed by labelStart[actors + 1] and hubs[entries] (32-bit ints), and then
+ * distances[entries] (one byte each).  The entries of actor a's label are those
+ * in [labelStart[a], labelStart[a + 1]).
+ */
+
+class distanceOracle {
+ public:
+
+  /**
+   * Convenience struct: buildReport
+   * -------------------------------
+   * What building a labelling cost, as reported by build.
+   */
+
+  struct buildReport {
+    long entries;      /// total number of (hub, distance) pairs over all labels
+    int maxLabelSize;  /// length of the longest label
+    double seconds;    /// time spent computing the labels
+    size_t fileSize;   /// size of the file written
+  };
+
+  distanceOracle();
+
+  /**
+   * Method: load
+   * ------------
+   * Maps the named labelling into memory, provided it exists, is well formed,
+   * and was built from data files of the specified sizes and stamp.
+   *
+   * @return true if and only if the oracle is now ready for queries.
+   */
+
+  bool load(const string& fileName, size_t actorFileSize, size_t movieFileSize,
+	    const dataStamp& stamp);
+
+  bool good() const { return fileMap != NULL; }
+
+  /**
+   * Method: getDistance
+   * -------------------
+   * Returns the length (in movies) of the shortest path between the two
+   * actors, identified by their graph IDs, or -1 if they aren't connected.
+   */
+
+  int getDistance(int actor, int other) const;
+
+  /**
+   * Method: build
+   * -------------
+   * Computes the pruned landmark labelling of the specified graph's actors and
+   * writes it to the named file.  The co-star adjacency is used for neighbours
+   * when supplied; otherwise neighbours are found through the graph's casts.
+   *
+   * @param costars the co-star adjacency for graph, or NULL.
+   * @param actorFileSize/movieFileSize the sizes of the data files the graph
+   *                                    was built from.
+   * @param stamp the stamp of those data files.
+   * @param report filled in with the cost of the build.
+   * @return true if and only if the file was written successfully.
+   */
+
+  static bool build(const string& fileName, const imdbGraph& graph, const costarGraph *costars,
+		    size_t actorFileSize, size_t movieFileSize, const dataStamp& stamp,
+		    buildReport& report);
+
+  ~distanceOracle();
+
+ private:
+  static const int kMagic = 0x6c626c73; // "slbl"
+  static const int kVersion = 2;
+  static const int kStampAt = 6;
+  static const int kHeaderInts = kStampAt + dataStamp::kInts;
+
+  const void *fileMap;
+  size_t fileSize;
+  int numActors;
+  const int *labelStart;
+  const int *hubs;
+  const uint8_t *distances;
+
+  distanceOracle(const distanceOracle& original);
+  distanceOracle& operator=(const distanceOracle& rhs);
+};
+
+#endif
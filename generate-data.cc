@@ -0,0 +1,546 @@
+#include <vector>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <unordered_map>
+#include <set>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <cmath>
+#include <climits>
+#include <cstdlib>
+#include <unistd.h>
+#include "imdb.h"
+#include "data-format.h"
+#include "movie-filter.h"
+using namespace std;
+
+/**
+ * Sidecars built from earlier data in the destination directory, removed
+ * so that none of them can be mistaken for one built from the new data.
+ */
+
+static const char *const kSidecarNames[] = {
+  "actorindex", "movieindex", "actorsuggest", "graphdata", "costardata", "labeldata", "validated"
+};
+
+static const char *const kFirstNames[] = {
+  "Ada", "Alan", "Alice", "Amir", "Anna", "Ben", "Bette", "Boris", "Carla", "Cary",
+  "Chen", "Clara", "Dana", "David", "Doris", "Elena", "Emil", "Errol", "Eva", "Felix",
+  "Frank", "Gene", "Greta", "Hana", "Harold", "Ida", "Ingrid", "Ivan", "James", "Joan",
+  "Kim", "Kurt", "Lana", "Lee", "Lucia", "Marco", "Maria", "Marlon", "Mei", "Nadia",
+  "Nils", "Olga", "Omar", "Paul", "Priya", "Rita", "Robert", "Rosa", "Sam", "Sofia",
+  "Spencer", "Tariq", "Tess", "Ugo", "Vera", "Victor", "Walter", "Yuki", "Zara", "Zoltan"
+};
+
+static const char *const kLastNames[] = {
+  "Abbott", "Alvarez", "Bacall", "Bergman", "Brando", "Cagney", "Castro", "Chaplin", "Chow", "Colbert",
+  "Crawford", "Dahl", "Davis", "Dietrich", "Dunne", "Eastwood", "Fonda", "Gable", "Garbo", "Garland",
+  "Grant", "Gupta", "Hayworth", "Hepburn", "Holden", "Huston", "Ito", "Jensen", "Karloff", "Kelly",
+  "Kim", "Kovacs", "Lamarr", "Lancaster", "Laurel", "Leigh", "Lorre", "Loy", "Lugosi", "March",
+  "Marx", "Mifune", "Mitchum", "Monroe", "Moreno", "Muni", "Nakamura", "Negri", "Novak", "Olivier",
+  "Peck", "Poitier", "Powell", "Quinn", "Raft", "Reyes", "Robinson", "Rossi", "Russell", "Sato",
+  "Schmidt", "Sellers", "Sinatra", "Stanwyck", "Stewart", "Swanson", "Taylor", "Temple", "Tracy", "Turner",
+  "Ullmann", "Valentino", "Vargas", "Wayne", "Welles", "West", "Wong", "Wood", "Young", "Zhang"
+};
+
+static const char *const kAdjectives[] = {
+  "Afternoon", "Bitter", "Broken", "Burning", "Crimson", "Dark", "Distant", "Endless", "Fallen", "Final",
+  "Forgotten", "Frozen", "Golden", "Hidden", "Hollow", "Last", "Long", "Lost", "Midnight", "Naked",
+  "Northern", "Painted", "Quiet", "Restless", "Scarlet", "Secret", "Silent", "Silver", "Stolen", "Strange",
+  "Sudden", "Sweet", "Tender", "Thin", "Twisted", "Velvet", "Wandering", "Whispering", "Wild", "Winter"
+};
+
+static const char *const kNouns[] = {
+  "Affair", "Alibi", "Angel", "Bargain", "Blues", "Bride", "Canyon", "City", "Coast", "Creek",
+  "Dawn", "Desire", "Detective", "Dream", "Empire", "Escape", "Frontier", "Garden", "Ghost", "Harbor",
+  "Heart", "Highway", "Horizon", "Hour", "House", "Island", "Journey", "Kingdom", "Letter", "Lady",
+  "Man", "Melody", "Mirror", "Mission", "Night", "Outlaw", "Passage", "Promise", "Rain", "River",
+  "Road", "Room", "Sea", "Season", "Shadow", "Sky", "Stranger", "Street", "Summer", "Sun",
+  "Thief", "Town", "Train", "Valley", "Voice", "Waltz", "Wind", "Witness", "Woman", "World"
+};
+
+template <typename T, size_t N>
+static size_t countOf(T (&)[N]) { return N; }
+
+/**
+ * The largest count a record's short can hold, which bounds both the
+ * size of a cast and the number of films an actor can be credited with.
+ */
+
+static const int kMaxContents = SHRT_MAX;
+
+/**
+ * Convenience struct: generatorOptions
+ * ------------------------------------
+ * Everything that shapes a generated dataset.  The same options always
+ * produce byte-for-byte the same files.
+ */
+
+struct generatorOptions {
+  unsigned long seed;
+  long numActors;
+  long numMovies;
+  double meanCast;      // the average number of actors per movie
+  double skew;          // how unevenly actors are cast, in [0, 1) (0 is evenly)
+  int numComponents;    // the number of connected components
+  double giantShare;    // the share of actors and movies in the first component, if there are several
+  int firstYear;
+  int lastYear;
+  bool canonical;       // write canonical data files rather than native legacy ones
+
+  generatorOptions() : seed(107), numActors(100000), numMovies(40000), meanCast(8), skew(0.5),
+		       numComponents(1), giantShare(0.9), firstYear(1920), lastYear(2020),
+		       canonical(false) {}
+};
+
+/**
+ * Returns a number in [0, bound), or in [0, 1), drawn from generator.  As in
+ * imdb-bench, the raw output of mt19937_64 is reduced by hand rather than
+ * through the standard distributions, whose output isn't pinned down by the
+ * standard, so a seed produces the same dataset with any standard library.
+ */
+
+static long drawBelow(mt19937_64& generator, long bound)
+{
+  return (long) (generator() % (unsigned long) bound);
+}
+
+static double drawUnit(mt19937_64& generator)
+{
+  return (generator() >> 11) * (1.0 / (1UL << 53));
+}
+
+static string romanNumeral(int n)
+{
+  static const int kValues[] = { 1000, 900, 500, 400, 100, 90, 50, 40, 10, 9, 5, 4, 1 };
+  static const char *const kDigits[] = { "M", "CM", "D", "CD", "C", "XC", "L", "XL", "X", "IX", "V", "IV", "I" };
+  string numeral;
+  for (int i = 0; n > 0; i++)
+    for (; n >= kValues[i]; n -= kValues[i]) numeral += kDigits[i];
+  return numeral;
+}
+
+/**
+ * Draws numActors distinct actor names.  Names are a first name, sometimes a
+ * middle initial, and a last name, and a name drawn more than once is told
+ * apart the way IMDb does it, by a Roman numeral: "Gene Kelly (II)".
+ */
+
+static void drawActorNames(mt19937_64& generator, long numActors, vector<string>& names)
+{
+  unordered_map<string, int> drawn;
+  names.clear();
+  for (long i = 0; i < numActors; i++) {
+    string name = kFirstNames[drawBelow(generator, countOf(kFirstNames))];
+    long initial = drawBelow(generator, 3 * 26);
+    if (initial < 26) name += string(" ") + (char) ('A' + initial) + ".";
+    name += string(" ") + kLastNames[drawBelow(generator, countOf(kLastNames))];
+    int times = ++drawn[name];
+    names.push_back(times == 1 ? name : name + " (" + romanNumeral(times) + ")");
+  }
+}
+
+/**
+ * Draws numMovies distinct films, with years spread evenly over the range.
+ * Titles repeat across years, as remakes do, and a title drawn twice for the
+ * same year becomes a sequel: "The Silent Harbor 2".
+ */
+
+static void drawMovies(mt19937_64& generator, const generatorOptions& options, vector<film>& movies)
+{
+  set<pair<string, int> > drawn;
+  movies.clear();
+  for (long i = 0; i < options.numMovies; i++) {
+    film movie;
+    movie.title = drawBelow(generator, 3) == 0 ? "The " : "";
+    movie.title += string(kAdjectives[drawBelow(generator, countOf(kAdjectives))]) + " " +
+      kNouns[drawBelow(generator, countOf(kNouns))];
+    movie.year = options.firstYear + drawBelow(generator, options.lastYear - options.firstYear + 1);
+    string title = movie.title;
+    for (int sequel = 2; !drawn.insert(make_pair(movie.title, movie.year)).second; sequel++)
+      movie.title = title + " " + to_string(sequel);
+    movies.push_back(movie);
+  }
+}
+
+/**
+ * Splits count items, taken in a random order, into numComponents groups:
+ * the first gets giantShare of them (or all of them, if there's only one
+ * group) and the rest share what's left evenly, each getting at least one.
+ * groups[c] lists the items of the cth group.
+ */
+
+static void splitIntoComponents(mt19937_64& generator, long count, const generatorOptions& options,
+				vector<vector<int> >& groups)
+{
+  vector<int> order(count);
+  iota(order.begin(), order.end(), 0);
+  for (long i = count - 1; i > 0; i--) swap(order[i], order[drawBelow(generator, i + 1)]);
+
+  int numComponents = options.numComponents;
+  long giant = numComponents == 1 ? count : (long) (count * options.giantShare);
+  giant = max(1L, min(giant, count - (numComponents - 1)));
+  groups.assign(numComponents, vector<int>());
+  groups[0].assign(order.begin(), order.begin() + giant);
+  for (long i = giant; i < count; i++)
+    groups[1 + (i - giant) % (numComponents - 1)].push_back(order[i]);
+}
+
+/**
+ * A union-find over actors, used to tie each component together.
+ */
+
+static int findRoot(vector<int>& parents, int actor)
+{
+  while (parents[actor] != actor) actor = parents[actor] = parents[parents[actor]];
+  return actor;
+}
+
+/**
+ * Picks a movie of a component to add one more actor to: one drawn at random,
+ * if one of the first few draws qualifies, and otherwise the first that
+ * qualifies in a scan from a random start, so that a component whose movies
+ * are nearly all full still gets through.
+ *
+ * @return the index into movies of the movie picked, or -1 if none qualifies.
+ */
+
+template <typename Predicate>
+static long pickMovie(mt19937_64& generator, const vector<int>& movies, Predicate qualifies)
+{
+  static const int kRandomTries = 64;
+  for (int tries = 0; tries < kRandomTries; tries++) {
+    long m = drawBelow(generator, movies.size());
+    if (qualifies(movies[m])) return m;
+  }
+  long start = drawBelow(generator, movies.size());
+  for (size_t i = 0; i < movies.size(); i++) {
+    long m = (start + i) % movies.size();
+    if (qualifies(movies[m])) return m;
+  }
+  return -1;
+}
+
+/**
+ * Casts the movies of one component from its actors.  Each movie's cast size
+ * is drawn from a geometric distribution with the requested mean, and its
+ * members are drawn without replacement by popularity.  Each actor's
+ * popularity is drawn from a Pareto distribution with tail index 1 / skew, so
+ * credit counts have the long tail of real data (a few actors with hundreds of
+ * films, most with one or two), and the busiest actor's share of the credits
+ * shrinks as the data grows, as it does in reality.  Actors left without
+ * a credit are then added to a random movie, and finally each piece of the
+ * component that isn't connected to the rest gets one of its actors added to
+ * a movie that is, so that the component is connected.
+ *
+ * @return false if some actor couldn't be placed because every movie that
+ *         could take it already has a full cast of kMaxContents.
+ */
+
+static bool castComponent(mt19937_64& generator, const generatorOptions& options,
+			  const vector<int>& actors, const vector<int>& movies,
+			  vector<vector<int> >& casts, vector<int>& numCredits, vector<int>& lastCast)
+{
+  vector<double> cumulative(actors.size());
+  double total = 0;
+  for (size_t a = 0; a < actors.size(); a++) {
+    total += pow(1 - drawUnit(generator), -options.skew);
+    cumulative[a] = total;
+  }
+
+  long maxCast = min<long>(actors.size(), kMaxContents);
+  double failure = 1 - 1 / max(1.0, options.meanCast);
+  for (size_t m = 0; m < movies.size(); m++) {
+    vector<int>& cast = casts[movies[m]];
+    long size = 1;
+    if (failure > 0) size += (long) (log(1 - drawUnit(generator)) / log(failure));
+    size = min(size, maxCast);
+    for (long tries = 0; (long) cast.size() < size && tries < 20 * size; tries++) {
+      size_t drawn = upper_bound(cumulative.begin(), cumulative.end(), drawUnit(generator) * total) -
+	cumulative.begin();
+      int actor = actors[min(drawn, actors.size() - 1)];
+      if (lastCast[actor] == movies[m] || numCredits[actor] == kMaxContents) continue;
+      lastCast[actor] = movies[m];
+      numCredits[actor]++;
+      cast.push_back(actor);
+    }
+  }
+
+  for (size_t a = 0; a < actors.size(); a++) {
+    if (numCredits[actors[a]] > 0) continue;
+    long m = pickMovie(generator, movies, [&](int movie) { return (int) casts[movie].size() < kMaxContents; });
+    if (m == -1) return false;
+    vector<int>& cast = casts[movies[m]];
+    cast.push_back(actors[a]);
+    numCredits[actors[a]]++;
+  }
+
+  vector<int>& parents = lastCast;  // done with it; reuse its slots for the actors of this component
+  for (size_t a = 0; a < actors.size(); a++) parents[actors[a]] = actors[a];
+  for (size_t m = 0; m < movies.size(); m++) {
+    const vector<int>& cast = casts[movies[m]];
+    for (size_t i = 1; i < cast.size(); i++)
+      parents[findRoot(parents, cast[i])] = findRoot(parents, cast[0]);
+  }
+  int root = findRoot(parents, casts[movies[0]][0]);
+  for (size_t a = 0; a < actors.size(); a++) {
+    int piece = findRoot(parents, actors[a]);
+    if (piece == root || numCredits[actors[a]] == kMaxContents) continue;
+    long m = pickMovie(generator, movies, [&](int movie) {
+	const vector<int>& cast = casts[movie];
+	return !cast.empty() && findRoot(parents, cast[0]) == root && (int) cast.size() < kMaxContents;
+      });
+    if (m == -1) return false;
+    vector<int>& cast = casts[movies[m]];
+    cast.push_back(actors[a]);
+    numCredits[actors[a]]++;
+    parents[piece] = root;
+  }
+  for (size_t a = 0; a < actors.size(); a++) lastCast[actors[a]] = -1;
+  return true;
+}
+
+/**
+ * Appends one record to a data file payload, laid out exactly as getRecord
+ * reads it: the name and its terminator, the year byte for a movie, padding
+ * to bring the short count to an even offset, the count, padding to bring
+ * the offset array to a multiple of four bytes from the start of the record,
+ * and the array.
+ */
+
+static void appendRecord(vector<char>& data, const string& name, int year, int type,
+			 const vector<int>& offsets)
+{
+  size_t start = data.size();
+  data.insert(data.end(), name.begin(), name.end());
+  data.resize(start + name.size() + getShortPadding(type, name.size()), '\0');
+  if (type == imdb::MOVIE) data[start + name.size() + 1] = (char) (year - 1900);
+  short count = offsets.size();
+  data.insert(data.end(), (const char *) &count, (const char *) &count + sizeof(count));
+  if ((data.size() - start) % 4 != 0) data.resize(data.size() + 2, '\0');
+  data.insert(data.end(), (const char *) offsets.data(), (const char *) (offsets.data() + offsets.size()));
+}
+
+static size_t recordSize(const string& name, int type, size_t count)
+{
+  size_t size = name.size() + getShortPadding(type, name.size()) + sizeof(short);
+  if (size % 4 != 0) size += 2;
+  return size + count * sizeof(int);
+}
+
+/**
+ * Lays out one data file: the record count, the table of record offsets, and
+ * the records in sorted order.  sizes holds the size of each record in sorted
+ * order, and offsets receives the offset of each.
+ *
+ * @return false if the records wouldn't all be reachable through int offsets.
+ */
+
+static bool layOutTable(const vector<size_t>& sizes, vector<int>& offsets, vector<char>& data)
+{
+  int count = sizes.size();
+  size_t offset = sizeof(int) * (1 + sizes.size());
+  offsets.resize(sizes.size());
+  for (size_t i = 0; i < sizes.size(); i++) {
+    if (offset > INT_MAX) return false;
+    offsets[i] = offset;
+    offset += sizes[i];
+  }
+  data.reserve(offset);
+  data.insert(data.end(), (const char *) &count, (const char *) &count + sizeof(count));
+  data.insert(data.end(), (const char *) offsets.data(), (const char *) (offsets.data() + offsets.size()));
+  return true;
+}
+
+static bool writeDataFile(const string& fileName, const vector<char>& data, int type, bool canonical)
+{
+  if (canonical) return writeCanonicalDataFile(fileName, &data[0], data.size(), type);
+  ofstream out(fileName.c_str(), ios::binary | ios::trunc);
+  out.write(&data[0], data.size());
+  return out.good();
+}
+
+/**
+ * Function: loadReferenceCounts
+ * -----------------------------
+ * Copies the number of actors and movies, and the average cast size, from
+ * the data in the specified directory, scaled by the specified factor.
+ */
+
+static bool loadReferenceCounts(const string& directory, double scale, generatorOptions& options)
+{
+  imdb db(directory);
+  if (!db.good()) { cerr << db.getLoadErrorMessage() << endl; return false; }
+  long credits = 0;
+  for (int m = 0; m < db.getNumMovies(); m++) {
+    offsetArray cast;
+    credits += db.getCastRecords(db.getMovieRecordAt(m), cast);
+  }
+  options.numActors = (long) (db.getNumActors() * scale);
+  options.numMovies = (long) (db.getNumMovies() * scale);
+  options.meanCast = db.getNumMovies() == 0 ? options.meanCast : (double) credits / db.getNumMovies();
+  return true;
+}
+
+static void printUsage(const char *program)
+{
+  cerr << "Usage: " << program << " [--seed=N] [--actors=N] [--movies=N] [--like=directory] [--scale=X]" << endl
+       << "       [--cast=MEAN] [--skew=S] [--components=N] [--giant=PERCENT] [--years=FIRST-LAST]" << endl
+       << "       [--canonical] destination-directory" << endl;
+}
+
+/**
+ * Function: main
+ * --------------
+ * Generates a synthetic dataset, so that the search engines and the indexes
+ * can be exercised at sizes the real data doesn't reach, and writes it to the
+ * destination directory as actordata and moviedata files in exactly the
+ * layout getRecord reads: native legacy files by default, or canonical ones
+ * (see data-format.h) with --canonical.  The result is then opened to
+ * validate it.  Sidecars have to be built afresh for it.
+ *
+ * Usage: generate-data [options] destination-directory
+ *
+ *   --seed=N            the seed the whole dataset is drawn from (107)
+ *   --actors=N          the number of actors (100000)
+ *   --movies=N          the number of movies (40000)
+ *   --like=directory    take the number of actors and movies, and the
+ *                       average cast size, from the data in directory...
+ *   --scale=X           ...multiplied by X (1), so --scale=10 to --scale=100
+ *                       models the data growing ten- to a hundredfold
+ *   --cast=MEAN         the average cast size (8)
+ *   --skew=S            how unevenly credits are spread among actors, from 0
+ *                       (evenly) to just under 1 (0.5, which gives credit
+ *                       counts a power-law tail of exponent 3)
+ *   --components=N      the number of connected components (1)
+ *   --giant=PERCENT     the share of the actors and movies in the first
+ *                       component when there are several (90)
+ *   --years=FIRST-LAST  the years movies are spread over (1920-2020)
+ */
+
+int main(int argc, const char *argv[])
+{
+  generatorOptions options;
+  const char *likeDirectory = NULL, *destination = NULL;
+  double scale = 1;
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg.compare(0, 7, "--seed=") == 0) options.seed = strtoul(argv[i] + 7, NULL, 10);
+    else if (arg.compare(0, 9, "--actors=") == 0) options.numActors = atol(argv[i] + 9);
+    else if (arg.compare(0, 9, "--movies=") == 0) options.numMovies = atol(argv[i] + 9);
+    else if (arg.compare(0, 7, "--like=") == 0) likeDirectory = argv[i] + 7;
+    else if (arg.compare(0, 8, "--scale=") == 0) scale = atof(argv[i] + 8);
+    else if (arg.compare(0, 7, "--cast=") == 0) options.meanCast = atof(argv[i] + 7);
+    else if (arg.compare(0, 7, "--skew=") == 0) options.skew = atof(argv[i] + 7);
+    else if (arg.compare(0, 13, "--components=") == 0) options.numComponents = atoi(argv[i] + 13);
+    else if (arg.compare(0, 8, "--giant=") == 0) options.giantShare = atof(argv[i] + 8) / 100;
+    else if (arg.compare(0, 8, "--years=") == 0) {
+      if (!parseYearRange(arg.substr(8), options.firstYear, options.lastYear)) {
+	cerr << "Couldn't make sense of the year range \"" << arg.substr(8) << "\"." << endl;
+	return 1;
+      }
+      options.firstYear = max(options.firstYear, 1900);
+      options.lastYear = min(options.lastYear, 1900 + CHAR_MAX);
+    } else if (arg == "--canonical") options.canonical = true;
+    else if (arg.compare(0, 2, "--") == 0 || destination != NULL) { printUsage(argv[0]); return 1; }
+    else destination = argv[i];
+  }
+  if (destination == NULL) { printUsage(argv[0]); return 1; }
+  if (likeDirectory != NULL) {
+    if (!loadReferenceCounts(likeDirectory, scale, options)) return 1;
+  } else {
+    options.numActors = (long) (options.numActors * scale);
+    options.numMovies = (long) (options.numMovies * scale);
+  }
+  if (options.numComponents < 1 || options.numActors < options.numComponents ||
+      options.numMovies < options.numComponents || options.numActors > INT_MAX / 64 ||
+      options.numMovies > INT_MAX / 64 || options.firstYear > options.lastYear ||
+      options.giantShare <= 0 || options.giantShare > 1 || options.skew < 0 || options.skew >= 1) {
+    cerr << "Can't generate " << options.numActors << " actors and " << options.numMovies
+	 << " movies in " << options.numComponents << " components over " << options.firstYear
+	 << "-" << options.lastYear << " with a skew of " << options.skew << "." << endl;
+    return 1;
+  }
+
+  mt19937_64 generator(options.seed);
+  vector<string> names;
+  vector<film> movies;
+  drawActorNames(generator, options.numActors, names);
+  drawMovies(generator, options, movies);
+  vector<vector<int> > actorGroups, movieGroups;
+  splitIntoComponents(generator, options.numActors, options, actorGroups);
+  splitIntoComponents(generator, options.numMovies, options, movieGroups);
+  vector<vector<int> > casts(options.numMovies);
+  vector<int> numCredits(options.numActors, 0), scratch(options.numActors, -1);
+  for (int c = 0; c < options.numComponents; c++) {
+    if (!castComponent(generator, options, actorGroups[c], movieGroups[c], casts, numCredits, scratch)) {
+      cerr << "Can't fit the " << actorGroups[c].size() << " actors of component " << c + 1 << " into its "
+	   << movieGroups[c].size() << " movies, which can cast at most " << kMaxContents
+	   << " actors each.  Aborting..." << endl;
+      return 1;
+    }
+  }
+
+  // Sort both files' records, and lay them out.
+  vector<int> actorOrder(options.numActors), movieOrder(options.numMovies);
+  iota(actorOrder.begin(), actorOrder.end(), 0);
+  iota(movieOrder.begin(), movieOrder.end(), 0);
+  sort(actorOrder.begin(), actorOrder.end(), [&](int one, int two) { return names[one] < names[two]; });
+  sort(movieOrder.begin(), movieOrder.end(), [&](int one, int two) { return movies[one] < movies[two]; });
+  vector<size_t> actorSizes, movieSizes;
+  for (long i = 0; i < options.numActors; i++)
+    actorSizes.push_back(recordSize(names[actorOrder[i]], imdb::ACTOR, numCredits[actorOrder[i]]));
+  for (long i = 0; i < options.numMovies; i++)
+    movieSizes.push_back(recordSize(movies[movieOrder[i]].title, imdb::MOVIE, casts[movieOrder[i]].size()));
+  vector<int> actorOffsets, movieOffsets;  // by sorted position
+  vector<char> actorData, movieData;
+  if (!layOutTable(actorSizes, actorOffsets, actorData) || !layOutTable(movieSizes, movieOffsets, movieData)) {
+    cerr << "The dataset would outgrow the int offsets of the data files.  Aborting..." << endl;
+    return 1;
+  }
+  vector<int> actorOffsetOf(options.numActors), movieOffsetOf(options.numMovies);
+  for (long i = 0; i < options.numActors; i++) actorOffsetOf[actorOrder[i]] = actorOffsets[i];
+  for (long i = 0; i < options.numMovies; i++) movieOffsetOf[movieOrder[i]] = movieOffsets[i];
+
+  // Both offset arrays are written in ascending order: credits because the
+  // movies are visited in sorted order, and casts sorted explicitly.
+  vector<vector<int> > credits(options.numActors);
+  long numCreditsTotal = 0;
+  int largestCast = 0, mostCredits = 0;
+  for (long i = 0; i < options.numMovies; i++) {
+    int movie = movieOrder[i];
+    vector<int> cast;
+    for (size_t j = 0; j < casts[movie].size(); j++) {
+      cast.push_back(actorOffsetOf[casts[movie][j]]);
+      credits[casts[movie][j]].push_back(movieOffsets[i]);
+    }
+    sort(cast.begin(), cast.end());
+    appendRecord(movieData, movies[movie].title, movies[movie].year, imdb::MOVIE, cast);
+    numCreditsTotal += cast.size();
+    largestCast = max<int>(largestCast, cast.size());
+  }
+  for (long i = 0; i < options.numActors; i++) {
+    appendRecord(actorData, names[actorOrder[i]], 0, imdb::ACTOR, credits[actorOrder[i]]);
+    mostCredits = max<int>(mostCredits, credits[actorOrder[i]].size());
+  }
+
+  string directory = destination;
+  if (!writeDataFile(directory + "/actordata", actorData, imdb::ACTOR, options.canonical) ||
+      !writeDataFile(directory + "/moviedata", movieData, imdb::MOVIE, options.canonical)) {
+    cerr << "Couldn't write the data files to " << directory << "." << endl;
+    return 1;
+  }
+  for (size_t i = 0; i < countOf(kSidecarNames); i++) unlink((directory + "/" + kSidecarNames[i]).c_str());
+
+  imdb db(directory);
+  if (!db.good()) { cerr << db.getLoadErrorMessage() << "  Aborting..." << endl; return 1; }
+  cout << "Wrote " << db.getNumActors() << " actors and " << db.getNumMovies() << " movies in "
+       << options.numComponents << " component" << (options.numComponents == 1 ? "" : "s")
+       << " to " << directory << ": " << numCreditsTotal << " credits, "
+       << (double) numCreditsTotal / options.numMovies << " actors per movie (at most "
+       << largestCast << "), " << (double) numCreditsTotal / options.numActors
+       << " movies per actor (at most " << mostCredits << ")." << endl;
+  return 0;
+}
@@ -0,0 +1,457 @@
+#include <vector>
+#include <string>
+#include <map>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <random>
+#include <functional>
+#include <cstdlib>
+#include "imdb.h"
+#include "path.h"
+#include "shortest-path.h"
+using namespace std;
+
+/**
+ * Every file an imdb may map, data files and sidecars alike, so that
+ * a cold start can evict them all.
+ */
+
+static const char *const kDataFileNames[] = {
+  "actordata", "moviedata", "actorindex", "movieindex", "actorsuggest",
+  "graphdata", "costardata", "labeldata", "validated"
+};
+
+static const char *const kPathClasses[] = { "short", "medium", "long", "unreachable" };
+static const int kNumPathClasses = sizeof(kPathClasses) / sizeof(kPathClasses[0]);
+
+/**
+ * Convenience struct: benchOptions
+ * --------------------------------
+ * Everything that shapes a run of the suite.  Two runs with the same options
+ * against the same data files measure exactly the same work.
+ */
+
+struct benchOptions {
+  unsigned long seed;
+  int numActors;        // actors sampled for lookups, credits, and casts
+  int pairsPerClass;    // actor pairs timed for each class of path
+  int maxPairTries;     // pairs sampled while filling the classes
+  int rounds;           // timed repetitions of every benchmark
+  int coldRounds;       // repetitions of the cold and warm start benchmarks
+  vector<string> engines;
+
+  benchOptions() : seed(107), numActors(1000), pairsPerClass(20), maxPairTries(4000),
+		   rounds(5), coldRounds(3) {
+    engines.push_back("bidirectional");
+    engines.push_back("records");
+    engines.push_back("graph");
+  }
+};
+
+/**
+ * Convenience struct: benchResult
+ * -------------------------------
+ * One benchmark's measurements: the time each round of ops operations
+ * took, and any further figures worth reporting alongside.
+ */
+
+struct benchResult {
+  string name;
+  long ops;
+  vector<double> roundSeconds;
+  vector<pair<string, double> > extras;
+
+  double nsPerOp() const {
+    vector<double> sorted = roundSeconds;
+    sort(sorted.begin(), sorted.end());
+    return ops == 0 || sorted.empty() ? 0 : sorted[sorted.size() / 2] * 1e9 / ops;
+  }
+
+  double minNsPerOp() const {
+    return ops == 0 || roundSeconds.empty() ? 0 :
+      *min_element(roundSeconds.begin(), roundSeconds.end()) * 1e9 / ops;
+  }
+};
+
+/**
+ * Returns a number in [0, bound) drawn from generator.  The raw output of
+ * mt19937 is specified exactly by the standard, but the distributions built
+ * on it aren't, so the reduction is done here to keep workloads identical
+ * across standard libraries.
+ */
+
+static long drawBelow(mt19937_64& generator, long bound)
+{
+  return (long) (generator() % (unsigned long) bound);
+}
+
+/**
+ * Runs op once untimed, to warm caches and let any per-thread state settle,
+ * and then rounds more times, timing each.  op performs ops operations per
+ * call and returns a checksum, which is folded into a sink so the work can't
+ * be skipped.  A round repeats op as often as it takes to last at least
+ * kMinRoundSeconds (judged by the warm-up call), so quick benchmarks aren't
+ * swamped by timer resolution and scheduling noise.
+ */
+
+static const double kMinRoundSeconds = 0.05;
+static long checksumSink = 0;
+
+static benchResult measure(const string& name, long ops, int rounds, const function<long()>& op)
+{
+  double start = monotonicSeconds();
+  checksumSink += op();
+  double warmup = monotonicSeconds() - start;
+  long repeats = warmup >= kMinRoundSeconds ? 1 : (long) (kMinRoundSeconds / max(warmup, 1e-7)) + 1;
+
+  benchResult result;
+  result.name = name;
+  result.ops = ops * repeats;
+  for (int r = 0; r < rounds; r++) {
+    start = monotonicSeconds();
+    for (long i = 0; i < repeats; i++) checksumSink += op();
+    result.roundSeconds.push_back(monotonicSeconds() - start);
+  }
+  return result;
+}
+
+static string resultAsJson(const benchResult& result)
+{
+  ostringstream json;
+  json << "{\"benchmark\": " << jsonQuote(result.name) << ", \"ops\": " << result.ops
+       << ", \"rounds\": " << result.roundSeconds.size()
+       << ", \"nsPerOp\": " << result.nsPerOp() << ", \"minNsPerOp\": " << result.minNsPerOp()
+       << ", \"opsPerSec\": " << (result.nsPerOp() > 0 ? 1e9 / result.nsPerOp() : 0);
+  for (size_t i = 0; i < result.extras.size(); i++)
+    json << ", " << jsonQuote(result.extras[i].first) << ": " << result.extras[i].second;
+  json << "}";
+  return json.str();
+}
+
+/**
+ * Name lookups that hit (sampled actors and their first movies) and miss (the
+ * same names with a suffix no real name carries), under the imdb's default
+ * lookup method.
+ */
+
+static void benchLookups(const imdb& db, const vector<int>& actors, const benchOptions& options,
+			 vector<benchResult>& results)
+{
+  vector<string> hits, misses;
+  vector<film> movies;
+  for (size_t i = 0; i < actors.size(); i++) {
+    hits.push_back(db.getActorName(actors[i]));
+    misses.push_back(hits.back() + " (uncredited)");
+    offsetArray credits;
+    if (db.getCreditRecords(actors[i], credits) > 0) movies.push_back(db.getMovie(credits[0]));
+  }
+  results.push_back(measure("lookup/actor-hit", hits.size(), options.rounds, [&] {
+    long found = 0;
+    for (size_t i = 0; i < hits.size(); i++) found += db.getActorRecord(hits[i]) != -1;
+    return found;
+  }));
+  results.push_back(measure("lookup/actor-miss", misses.size(), options.rounds, [&] {
+    long found = 0;
+    for (size_t i = 0; i < misses.size(); i++) found += db.getActorRecord(misses[i]) != -1;
+    return found;
+  }));
+  results.push_back(measure("lookup/movie-hit", movies.size(), options.rounds, [&] {
+    long found = 0;
+    for (size_t i = 0; i < movies.size(); i++) found += db.getMovieRecord(movies[i]) != -1;
+    return found;
+  }));
+}
+
+/**
+ * getCredits and getCast throughput over the sampled actors and their first
+ * movies, counted in calls, with the number of films or cast members each
+ * call returned on average reported alongside.
+ */
+
+static void benchCreditsAndCasts(const imdb& db, const vector<int>& actors,
+				 const benchOptions& options, vector<benchResult>& results)
+{
+  vector<string> names;
+  vector<film> movies;
+  for (size_t i = 0; i < actors.size(); i++) {
+    names.push_back(db.getActorName(actors[i]));
+    offsetArray credits;
+    if (db.getCreditRecords(actors[i], credits) > 0) movies.push_back(db.getMovie(credits[0]));
+  }
+  long filmsReturned = 0, castReturned = 0;
+  benchResult credits = measure("getCredits", names.size(), options.rounds, [&] {
+    filmsReturned = 0;
+    for (size_t i = 0; i < names.size(); i++) {
+      vector<film> films;
+      db.getCredits(names[i], films);
+      filmsReturned += films.size();
+    }
+    return filmsReturned;
+  });
+  credits.extras.push_back(make_pair("filmsPerCall", (double) filmsReturned / max<size_t>(1, names.size())));
+  results.push_back(credits);
+  benchResult cast = measure("getCast", movies.size(), options.rounds, [&] {
+    castReturned = 0;
+    for (size_t i = 0; i < movies.size(); i++) {
+      vector<string> players;
+      db.getCast(movies[i], players);
+      castReturned += players.size();
+    }
+    return castReturned;
+  });
+  cast.extras.push_back(make_pair("castPerCall", (double) castReturned / max<size_t>(1, movies.size())));
+  results.push_back(cast);
+}
+
+/**
+ * Samples actor pairs and sorts them into classes by the length of the
+ * shortest path between them (as found by the "records" engine): short (one
+ * or two movies), medium (three), long (four or more), and unreachable
+ * (nothing within the path length limit), until every class holds
+ * pairsPerClass pairs or maxPairTries pairs have been tried.
+ */
+
+static void classifyPairs(const imdb& db, mt19937_64& generator, const benchOptions& options,
+			  vector<pair<string, string> > classes[])
+{
+  for (int tries = 0; tries < options.maxPairTries; tries++) {
+    bool full = true;
+    for (int c = 0; c < kNumPathClasses; c++)
+      if ((int) classes[c].size() < options.pairsPerClass) full = false;
+    if (full) break;
+    string source = db.getActorName(db.getActorRecordAt(drawBelow(generator, db.getNumActors())));
+    string target = db.getActorName(db.getActorRecordAt(drawBelow(generator, db.getNumActors())));
+    if (source == target) continue;
+    path found = getShortestPathByRecord(source, target, db);
+    int length = found.getLastPlayer() == "" ? -1 : found.getLength();
+    int c = length == -1 ? 3 : length <= 2 ? 0 : length == 3 ? 1 : 2;
+    if ((int) classes[c].size() < options.pairsPerClass) classes[c].push_back(make_pair(source, target));
+  }
+}
+
+/**
+ * Times every selected engine over every class of pairs, with the number of
+ * actors each query expanded reported alongside.
+ */
+
+static void benchPaths(const imdb& db, vector<pair<string, string> > classes[],
+		       const benchOptions& options, vector<benchResult>& results)
+{
+  for (size_t e = 0; e < options.engines.size(); e++) {
+    searchEngine search = lookupSearchEngine(options.engines[e]);
+    if (search == NULL) {
+      cerr << "Skipping unknown search engine \"" << options.engines[e] << "\"." << endl;
+      continue;
+    }
+    for (int c = 0; c < kNumPathClasses; c++) {
+      const vector<pair<string, string> >& pairs = classes[c];
+      if (pairs.empty()) continue;
+      searchStats stats;
+      for (size_t i = 0; i < pairs.size(); i++) search(pairs[i].first, pairs[i].second, db, &stats);
+      benchResult result = measure("path/" + options.engines[e] + "/" + kPathClasses[c], pairs.size(),
+				   options.rounds, [&] {
+	long length = 0;
+	for (size_t i = 0; i < pairs.size(); i++)
+	  length += search(pairs[i].first, pairs[i].second, db, NULL).getLength();
+	return length;
+      });
+      result.extras.push_back(make_pair("actorsExpandedPerQuery", (double) stats.actorsExpanded / pairs.size()));
+      results.push_back(result);
+    }
+  }
+}
+
+/**
+ * Times opening an imdb and answering one query with it, first with every
+ * file it maps evicted from the page cache (a cold start, as after a fresh
+ * deploy) and then again straight afterwards (a warm one).  Each op is one
+ * open plus one query; the open alone is reported as openMs.
+ *
+ * @return false, after reporting why, if an imdb couldn't be opened.
+ */
+
+static bool benchStartup(const string& directory, const pair<string, string>& query,
+			 const benchOptions& options, vector<benchResult>& results)
+{
+  for (int warm = 0; warm < 2; warm++) {
+    benchResult result;
+    result.name = warm ? "start/warm" : "start/cold";
+    result.ops = 1;
+    double openSeconds = 0;
+    for (int r = 0; r < options.coldRounds; r++) {
+      if (!warm)
+	for (size_t f = 0; f < sizeof(kDataFileNames) / sizeof(kDataFileNames[0]); f++)
+	  evictFile(directory + "/" + kDataFileNames[f]);
+      double start = monotonicSeconds();
+      imdb db(directory);
+      double opened = monotonicSeconds();
+      if (!db.good()) {
+	cerr << db.getLoadErrorMessage() << "  Aborting..." << endl;
+	return false;
+      }
+      checksumSink += getShortestPathByRecord(query.first, query.second, db).getLength();
+      result.roundSeconds.push_back(monotonicSeconds() - start);
+      openSeconds += opened - start;
+    }
+    result.extras.push_back(make_pair("openMs", openSeconds * 1000 / options.coldRounds));
+    results.push_back(result);
+  }
+  return true;
+}
+
+/**
+ * Reads the nsPerOp of every benchmark from a results file this program wrote
+ * earlier.  Only the fields this program writes are understood.
+ */
+
+static bool readBaseline(const char *fileName, map<string, double>& baseline)
+{
+  ifstream in(fileName);
+  if (!in) return false;
+  string line;
+  const string nameField = "\"benchmark\": \"", timeField = "\"nsPerOp\": ";
+  while (getline(in, line)) {
+    size_t name = line.find(nameField), time = line.find(timeField);
+    if (name == string::npos || time == string::npos) continue;
+    name += nameField.size();
+    baseline[line.substr(name, line.find('"', name) - name)] = atof(line.c_str() + time + timeField.size());
+  }
+  return true;
+}
+
+/**
+ * Compares every result against the baseline, reporting on cerr each
+ * benchmark whose median time per op grew by more than tolerance (a fraction).
+ *
+ * @return the number of regressions found.
+ */
+
+static int compareWithBaseline(const vector<benchResult>& results, const map<string, double>& baseline,
+			       double tolerance)
+{
+  int regressions = 0;
+  for (size_t i = 0; i < results.size(); i++) {
+    map<string, double>::const_iterator found = baseline.find(results[i].name);
+    if (found == baseline.end() || found->second <= 0) continue;
+    double ratio = results[i].nsPerOp() / found->second;
+    if (ratio <= 1 + tolerance) continue;
+    cerr << "REGRESSION " << results[i].name << ": " << results[i].nsPerOp() << " ns/op, was "
+	 << found->second << " ns/op (" << (ratio - 1) * 100 << "% slower)" << endl;
+    regressions++;
+  }
+  return regressions;
+}
+
+static void splitList(const string& list, vector<string>& items)
+{
+  items.clear();
+  for (size_t start = 0; start <= list.size(); ) {
+    size_t end = list.find(',', start);
+    if (end == string::npos) end = list.size();
+    if (end > start) items.push_back(list.substr(start, end - start));
+    start = end + 1;
+  }
+}
+
+/**
+ * Serves as the main entry point for the imdb-bench executable, the
+ * reproducible benchmark suite run by make bench.
+ *
+ * Usage: imdb-bench [--seed=N] [--actors=N] [--pairs=N] [--rounds=N]
+ *                   [--engines=a,b,...] [--output=file]
+ *                   [--baseline=file [--tolerance=F]] [data-directory]
+ *
+ * A workload is drawn from the data files with a fixed seed (107 unless
+ * --seed says otherwise): --actors actors for the lookup, getCredits, and
+ * getCast benchmarks, and up to --pairs actor pairs for each class of path
+ * (short, medium, long, unreachable).  Every benchmark is run once to warm
+ * up and then --rounds times; results are written one JSON object per line,
+ * after a line describing the workload, with the median (nsPerOp) and best
+ * (minNsPerOp) time per operation.  --engines picks the search engines timed
+ * (bidirectional, records, and graph by default; bfs is slow enough on the
+ * full data to be left out unless asked for).
+ *
+ * With --baseline, the median of each benchmark is compared against the same
+ * benchmark in an earlier results file, and any that slowed by more than
+ * --tolerance (0.10, or 10%, by default) are listed on cerr.
+ *
+ * @return 0, or 1 if the data couldn't be opened or a regression was found.
+ */
+
+int main(int argc, const char *argv[])
+{
+  benchOptions options;
+  const char *dataDirectory = NULL, *outputFile = NULL, *baselineFile = NULL;
+  double tolerance = 0.10;
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg.compare(0, 7, "--seed=") == 0) options.seed = strtoul(argv[i] + 7, NULL, 10);
+    else if (arg.compare(0, 9, "--actors=") == 0) options.numActors = max(1, atoi(argv[i] + 9));
+    else if (arg.compare(0, 8, "--pairs=") == 0) options.pairsPerClass = max(1, atoi(argv[i] + 8));
+    else if (arg.compare(0, 9, "--rounds=") == 0) options.rounds = max(1, atoi(argv[i] + 9));
+    else if (arg.compare(0, 10, "--engines=") == 0) splitList(arg.substr(10), options.engines);
+    else if (arg.compare(0, 9, "--output=") == 0) outputFile = argv[i] + 9;
+    else if (arg.compare(0, 11, "--baseline=") == 0) baselineFile = argv[i] + 11;
+    else if (arg.compare(0, 12, "--tolerance=") == 0) tolerance = atof(argv[i] + 12);
+    else dataDirectory = argv[i];
+  }
+
+  map<string, double> baseline;
+  if (baselineFile != NULL && !readBaseline(baselineFile, baseline)) {
+    cerr << "Couldn't open \"" << baselineFile << "\"." << endl;
+    return 1;
+  }
+  ofstream file;
+  if (outputFile != NULL) {
+    file.open(outputFile);
+    if (!file) { cerr << "Couldn't write \"" << outputFile << "\"." << endl; return 1; }
+  }
+  ostream& out = outputFile != NULL ? file : cout;
+
+  string directory = determinePathToData(dataDirectory);
+  vector<benchResult> results;
+  vector<pair<string, string> > classes[kNumPathClasses];
+  {
+    imdb db(directory);
+    if (!db.good() || db.getNumActors() == 0) {
+      cerr << "Couldn't open the data in \"" << directory << "\": " << db.getLoadErrorMessage() << endl;
+      return 1;
+    }
+    mt19937_64 generator(options.seed);
+    vector<int> actors;
+    for (int i = 0; i < options.numActors; i++)
+      actors.push_back(db.getActorRecordAt(drawBelow(generator, db.getNumActors())));
+    classifyPairs(db, generator, options, classes);
+
+    out << "{\"workload\": \"imdb-bench\", \"seed\": " << options.seed
+	<< ", \"actors\": " << db.getNumActors() << ", \"movies\": " << db.getNumMovies()
+	<< ", \"sampledActors\": " << actors.size() << ", \"rounds\": " << options.rounds
+	<< ", \"maxPathLength\": " << getMaxPathLength() << ", \"pairs\": {";
+    for (int c = 0; c < kNumPathClasses; c++)
+      out << (c > 0 ? ", " : "") << "\"" << kPathClasses[c] << "\": " << classes[c].size();
+    out << "}}" << endl;
+
+    size_t reported = 0;
+    benchLookups(db, actors, options, results);
+    benchCreditsAndCasts(db, actors, options, results);
+    for (; reported < results.size(); reported++) out << resultAsJson(results[reported]) << endl;
+    benchPaths(db, classes, options, results);
+    for (; reported < results.size(); reported++) out << resultAsJson(results[reported]) << endl;
+  }
+
+  pair<string, string> startQuery;
+  for (int c = 0; c < kNumPathClasses && startQuery.first.empty(); c++)
+    if (!classes[c].empty()) startQuery = classes[c][0];
+  size_t reported = results.size();
+  if (!benchStartup(directory, startQuery, options, results)) return 1;
+  for (; reported < results.size(); reported++) out << resultAsJson(results[reported]) << endl;
+
+  if (baselineFile != NULL) {
+    int regressions = compareWithBaseline(results, baseline, tolerance);
+    cerr << regressions << " regression(s) against \"" << baselineFile << "\"." << endl;
+    if (regressions > 0) return 1;
+  }
+  return 0;
+}
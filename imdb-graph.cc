@@ -0,0 +1,152 @@
+using namespace std;
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <unordered_map>
+#include "imdb-graph.h"
+#include "imdb.h"
+
+imdbGraph::imdbGraph() :
+  fileMap(NULL), fileSize(0), numActors(0), numMovies(0), creditStart(NULL), credits(NULL),
+  castStart(NULL), cast(NULL), nameStart(NULL), titleStart(NULL), years(NULL),
+  namePool(NULL), titlePool(NULL) {}
+
+/**
+ * As with nameIndex, a snapshot is only trusted if its header matches
+ * the data files and its size is exactly what the header implies.
+ */
+
+bool imdbGraph::load(const string& fileName, size_t actorFileSize, size_t movieFileSize,
+		     const dataStamp& stamp)
+{
+  int fd = open(fileName.c_str(), O_RDONLY);
+  if (fd == -1) return false;
+  struct stat stats;
+  if (fstat(fd, &stats) == -1 || stats.st_size < (off_t) (kHeaderInts * sizeof(int))) {
+    close(fd);
+    return false;
+  }
+  void *map = mmap(0, stats.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) return false;
+
+  const int *header = (const int *) map;
+  size_t actors = header[4], movies = header[5], edges = header[6];
+  size_t expectedSize = (kHeaderInts + (actors + 1) + edges + (movies + 1) + edges +
+			 actors + movies + movies) * sizeof(int) + header[7] + header[8];
+  if (header[0] != kMagic || header[1] != kVersion || header[2] != (int) actorFileSize ||
+      header[3] != (int) movieFileSize || expectedSize != (size_t) stats.st_size ||
+      !stamp.matches(header + kStampAt)) {
+    munmap(map, stats.st_size);
+    return false;
+  }
+
+  fileMap = map;
+  fileSize = stats.st_size;
+  numActors = actors;
+  numMovies = movies;
+  creditStart = header + kHeaderInts;
+  credits = creditStart + actors + 1;
+  castStart = credits + edges;
+  cast = castStart + movies + 1;
+  nameStart = cast + edges;
+  titleStart = nameStart + actors;
+  years = titleStart + movies;
+  namePool = (const char *) (years + movies);
+  titlePool = namePool + header[7];
+  return true;
+}
+
+int imdbGraph::findActor(const string& name) const
+{
+  int low = 0, high = numActors - 1;
+  while (low <= high) {
+    int middle = low + (high - low) / 2;
+    int cmp = strcmp(name.c_str(), getActorName(middle));
+    if (cmp == 0) return middle;
+    if (cmp < 0) high = middle - 1;
+    else low = middle + 1;
+  }
+  return -1;
+}
+
+/**
+ * Appends the specified string, NUL terminator included, to the pool.
+ */
+
+static void appendToPool(vector<char>& pool, const string& s)
+{
+  pool.insert(pool.end(), s.c_str(), s.c_str() + s.size() + 1);
+}
+
+static bool writeInts(FILE *out, const vector<int>& ints)
+{
+  return fwrite(&ints[0], sizeof(int), ints.size(), out) == ints.size();
+}
+
+/**
+ * The imdb's record offsets are turned into dense IDs by way of two hash
+ * maps built up front; every other array falls out of a single pass over
+ * each of the offset tables.
+ */
+
+bool imdbGraph::write(const string& fileName, const imdb& db)
+{
+  int actors = db.getNumActors(), movies = db.getNumMovies();
+  unordered_map<int, int> actorID, movieID;
+  for (int i = 0; i < actors; i++) actorID[db.getActorRecordAt(i)] = i;
+  for (int i = 0; i < movies; i++) movieID[db.getMovieRecordAt(i)] = i;
+
+  vector<int> creditStart(1, 0), credits, nameStart;
+  vector<char> namePool;
+  for (int i = 0; i < actors; i++) {
+    offsetArray records;
+    int count = db.getCreditRecords(db.getActorRecordAt(i), records);
+    for (int j = 0; j < count; j++) credits.push_back(movieID[records[j]]);
+    creditStart.push_back(credits.size());
+    nameStart.push_back(namePool.size());
+    appendToPool(namePool, db.getActorName(db.getActorRecordAt(i)));
+  }
+
+  vector<int> castStart(1, 0), cast, titleStart, years;
+  vector<char> titlePool;
+  for (int i = 0; i < movies; i++) {
+    offsetArray records;
+    int count = db.getCastRecords(db.getMovieRecordAt(i), records);
+    for (int j = 0; j < count; j++) cast.push_back(actorID[records[j]]);
+    castStart.push_back(cast.size());
+    film movie = db.getMovie(db.getMovieRecordAt(i));
+    titleStart.push_back(titlePool.size());
+    appendToPool(titlePool, movie.title);
+    years.push_back(movie.year);
+  }
+  if (credits.size() != cast.size()) return false; // the two files disagree
+  namePool.resize((namePool.size() + 3) & ~3, '\0');
+  titlePool.resize((titlePool.size() + 3) & ~3, '\0');
+
+  FILE *out = fopen(fileName.c_str(), "wb");
+  if (out == NULL) return false;
+  int header[kHeaderInts] = {
+    kMagic, kVersion, (int) db.getFileSize(imdb::ACTOR), (int) db.getFileSize(imdb::MOVIE),
+    actors, movies, (int) credits.size(), (int) namePool.size(), (int) titlePool.size()
+  };
+  db.getDataStamp().store(header + kStampAt);
+  bool ok = fwrite(header, sizeof(int), kHeaderInts, out) == (size_t) kHeaderInts &&
+    writeInts(out, creditStart) && (credits.empty() || writeInts(out, credits)) &&
+    writeInts(out, castStart) && (cast.empty() || writeInts(out, cast)) &&
+    (actors == 0 || writeInts(out, nameStart)) &&
+    (movies == 0 || (writeInts(out, titleStart) && writeInts(out, years))) &&
+    fwrite(&namePool[0], 1, namePool.size(), out) == namePool.size() &&
+    fwrite(&titlePool[0], 1, titlePool.size(), out) == titlePool.size();
+  return fclose(out) == 0 && ok;
+}
+
+imdbGraph::~imdbGraph()
+{
+  if (fileMap != NULL) munmap((char *) fileMap, fileSize);
+}
@@ -0,0 +1,154 @@
+#ifndef __imdb_graph__
+#define __imdb_graph__
+
+#include <string>
+#include <stdint.h>
+#include "data-format.h"
+using namespace std;
+
+class imdb;
+
+/**
+ * Class: imdbGraph
+ * ----------------
+ * A compressed-sparse-row snapshot of the bipartite actor/movie graph stored
+ * in an imdb's data files, kept in a sidecar file named graphdata.  Actors
+ * and movies are renumbered with dense integer IDs (their positions in the
+ * sorted offset tables of actordata and moviedata), each one's neighbours
+ * sit in one contiguous run of a single array, and names, titles, and years
+ * live apart in their own pools.  A search touching an actor's credits reads
+ * one run of ints, sequentially, without parsing any record headers.
+ *
+ * The file layout, all native-endian, is a header of kHeaderInts 32-bit ints
+ *
+ *     magic, version, actor file size, movie file size,
+ *     number of actors, number of movies, number of credits,
+ *     actor name pool size, movie title pool size,
+ *     data stamp[dataStamp::kInts] (see data-format.h)
+ *
+ * followed by these 32-bit int arrays
+ *
+ *     creditStart[actors + 1]  the credits of actor a are
+ *                              credits[creditStart[a] .. creditStart[a + 1])
+ *     credits[credits]         movie IDs
+ *     castStart[movies + 1]    likewise for casts
+ *     cast[credits]            actor IDs
+ *     nameStart[actors]        offset of each actor's name in the name pool
+ *     titleStart[movies]       offset of each movie's title in the title pool
+ *     years[movies]
+ *
+ * and finally the name and title pools, each a run of NUL-terminated strings,
+ * padded to a multiple of four bytes.
+ */
+
+class imdbGraph {
+ public:
+
+  /**
+   * Constructor: imdbGraph
+   * ----------------------
+   * Constructs a graph with nothing loaded; good() returns false
+   * until load succeeds.
+   */
+
+  imdbGraph();
+
+  /**
+   * Method: load
+   * ------------
+   * Maps the named snapshot into memory, provided it exists, is well formed,
+   * and was built from data files of the specified sizes and stamp.
+   *
+   * @return true if and only if the graph is now ready for use.
+   */
+
+  bool load(const string& fileName, size_t actorFileSize, size_t movieFileSize,
+	    const dataStamp& stamp);
+
+  /**
+   * Predicate Method: good
+   * ----------------------
+   * Returns true if and only if a snapshot has been successfully loaded.
+   */
+
+  bool good() const { return fileMap != NULL; }
+
+  int getNumActors() const { return numActors; }
+  int getNumMovies() const { return numMovies; }
+
+  /**
+   * Methods: getCredits
+   *          getCast
+   * ------------------
+   * Set movies (or actors) to the base of the contiguous run of movie IDs the
+   * specified actor appeared in (or of actor IDs in the specified movie's cast).
+   *
+   * @return the length of the run.
+   */
+
+  int getCredits(int actor, const int *& movies) const {
+    movies = credits + creditStart[actor];
+    return creditStart[actor + 1] - creditStart[actor];
+  }
+
+  int getCast(int movie, const int *& actors) const {
+    actors = cast + castStart[movie];
+    return castStart[movie + 1] - castStart[movie];
+  }
+
+  const char *getActorName(int actor) const { return namePool + nameStart[actor]; }
+  const char *getMovieTitle(int movie) const { return titlePool + titleStart[movie]; }
+  int getMovieYear(int movie) const { return years[movie]; }
+
+  /**
+   * Method: findActor
+   * -----------------
+   * Returns the ID of the named actor, found by binary search over the name
+   * pool (IDs are assigned in name order), or -1 if there's no such actor.
+   */
+
+  int findActor(const string& name) const;
+
+  /**
+   * Method: write
+   * -------------
+   * Builds a snapshot of the specified imdb's data and writes it to the named file.
+   *
+   * @return true if and only if the file was written successfully.
+   */
+
+  static bool write(const string& fileName, const imdb& db);
+
+  /**
+   * Destructor: ~imdbGraph
+   * ----------------------
+   * Unmaps the snapshot, if one was loaded.
+   */
+
+  ~imdbGraph();
+
+ private:
+  static const int kMagic = 0x68707267; // "grph"
+  static const int kVersion = 2;
+  static const int kStampAt = 9;
+  static const int kHeaderInts = kStampAt + dataStamp::kInts;
+
+  const void *fileMap;
+  size_t fileSize;
+  int numActors;
+  int numMovies;
+  const int *creditStart;
+  const int *credits;
+  const int *castStart;
+  const int *cast;
+  const int *nameStart;
+  const int *titleStart;
+  const int *years;
+  const char *namePool;
+  const char *titlePool;
+
+  imdbGraph(const imdbGraph& original);
+  imdbGraph& operator=(const imdbGraph& rhs);
+};
+
+#endif
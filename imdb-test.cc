@@ -3,7 +3,10 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
+#include <algorithm>
 #include "imdb.h"
+#include "alloc-count.h"
 using namespace std;
 
 /**
@@ -70,58 +73,50 @@ static void listMovies(const string& player, const vector<film>& credits)
   stall();
 }
 
+/**
+ * Function: printCostar
+ * ---------------------
+ * Prints one numbered line of listCostars' output: the costar's
+ * name and, if more than one, the number of films shared.
+ */
+
+static void printCostar(int number, const imdb::costar& entry, const imdb& db)
+{
+  cout << setw(5) << number << ".) " << db.getActorName(entry.actor);
+  if (entry.sharedFilms > 1) cout << " (in " << entry.sharedFilms << " different films)";
+  cout << endl;
+}
+
 /**
  * Function: listCostars
  * ---------------------
  * Builds up the list of costars and then prints all these
  * costars in a format similar to that used by listMovies.
- * The STL set is used to collect actor/actress names without
- * storing duplicates.
+ * The co-stars are aggregated by record (see imdb::getCostars),
+ * so only the names actually printed are ever built.
  *
  * @param player the actor/actress of interest.
- * @param credits the list of movies that the specified actor/actress has appeared in.
- *                (No integrity checks are done, so it's the client's responsibility to make sure
- *                 the specified actor/actress really has appeared in these movies.)
- * @param db the imdb housing the specified plater, list of movies, etc.  This is passed in
- *           so that each member of each cast of each movie can be added to the specified player's
- *           set of costars.
+ * @param db the imdb housing the specified player.
  */
 
-static void listCostars(const string &player, const vector<film>& credits, const imdb& db)
+static void listCostars(const string &player, const imdb& db)
 {
   const unsigned int kNumCostarsToPrint = 10;
-  map<string, set<film> > costars;
-  for (int i = 0; i < (int) credits.size(); i++) {
-    const film& movie = credits[i];
-    vector<string> cast;
-    db.getCast(movie, cast);
-    for (int j = 0; j < (int) cast.size(); j++) {
-      const string& costar = cast[j];
-      if (costar != player) costars[costar].insert(movie);
-    }
-  }
+  vector<imdb::costar> costars;
+  db.getCostars(player, costars);
   
   cout << player << " has worked with " << (int) costars.size() << " other people." << endl;
   cout << "Those other people are:" << endl;
   
   unsigned int numCostars = 0;
-  map<string, set<film> >::const_iterator curr;
-  for (curr = costars.begin(); curr != costars.end() && numCostars < kNumCostarsToPrint; ++curr) {
-    const string& costar = curr->first;
-    cout << setw(5) << ++numCostars << ".) " << costar;
-    if (curr->second.size() > 1) cout << " (in " << (int) curr->second.size() << " different films)";
-    cout << endl;
-  }
+  for (; numCostars < costars.size() && numCostars < kNumCostarsToPrint; numCostars++)
+    printCostar(numCostars + 1, costars[numCostars], db);
 
-  if (curr != costars.end()) {
+  if (numCostars < costars.size()) {
     if (costars.size() > 2 * kNumCostarsToPrint) printFill();
-    while (numCostars < costars.size() - kNumCostarsToPrint) { numCostars++; ++curr; }
-    for (; curr != costars.end(); ++curr) {
-      const string& costar = curr->first;
-      cout << setw(5) << ++numCostars << ".) " << costar;
-      if (curr->second.size() > 1) cout << " (in " << (int) curr->second.size() << " different films)";
-      cout << endl;
-    }
+    numCostars = max(numCostars, (unsigned int) costars.size() - kNumCostarsToPrint);
+    for (; numCostars < costars.size(); numCostars++)
+      printCostar(numCostars + 1, costars[numCostars], db);
   }
 
   stall();
@@ -160,7 +155,7 @@ static void listAllMoviesAndCostars(const string& player,
   }
   
   listMovies(player, credits);
-  listCostars(player, credits, db);
+  listCostars(player, db);
 }
 
 /**
@@ -190,18 +185,146 @@ static void queryForActors(const imdb& db)
   }
 }
 
+/**
+ * Function: countCostarsByName
+ * ----------------------------
+ * The original co-star aggregation listCostars used, kept so the benchmark
+ * has a baseline: every cast is copied out as strings and every co-star
+ * inserted into a map<string, set<film> >.
+ */
+
+static size_t countCostarsByName(const string& player, const imdb& db)
+{
+  vector<film> credits;
+  db.getCredits(player, credits);
+  map<string, set<film> > costars;
+  for (int i = 0; i < (int) credits.size(); i++) {
+    vector<string> cast;
+    db.getCast(credits[i], cast);
+    for (int j = 0; j < (int) cast.size(); j++)
+      if (cast[j] != player) costars[cast[j]].insert(credits[i]);
+  }
+  return costars.size();
+}
+
+/**
+ * Function: benchmarkLookups
+ * --------------------------
+ * Measures how many actor and movie lookups per second the imdb manages
+ * under each of its lookup methods.  The keys are sampled evenly from
+ * across the data files, converted to strings and films up front, and then
+ * looked up over and over, so that only the lookups themselves are timed.
+ * The number of heap allocations made per lookup is reported as well, and
+ * so is the latency of top-10 name suggestions (by prefix, and by similar
+ * spelling, with one letter dropped from each name), if they were built,
+ * along with the cost of aggregating an actor's co-stars by record and by
+ * the original map of names.
+ *
+ * @param db the imdb being measured.  Its lookup method is left at INDEXED.
+ */
+
+static void benchmarkLookups(imdb& db)
+{
+  const int kNumSamples = 1000;
+  const int kNumRounds = 200;
+  vector<string> players;
+  vector<film> movies;
+  for (int i = 0; i < kNumSamples; i++) {
+    players.push_back(db.getActorName(db.getActorRecordAt((long) i * db.getNumActors() / kNumSamples)));
+    movies.push_back(db.getMovie(db.getMovieRecordAt((long) i * db.getNumMovies() / kNumSamples)));
+  }
+
+  const int methods[] = { imdb::REFERENCE_BSEARCH, imdb::BSEARCH, imdb::INDEXED };
+  const char *names[] = { "reference bsearch", "in-place bsearch", "name index" };
+  for (int m = 0; m < 3; m++) {
+    if (!db.setLookupMethod(methods[m])) {
+      cout << setw(20) << names[m] << ": not available (run build-index first)" << endl;
+      continue;
+    }
+    int misses = 0;
+    long allocationsBefore = getAllocationCount();
+    double start = monotonicSeconds();
+    for (int round = 0; round < kNumRounds; round++)
+      for (int i = 0; i < kNumSamples; i++)
+	if (db.getActorRecord(players[i]) == -1) misses++;
+    double middle = monotonicSeconds();
+    for (int round = 0; round < kNumRounds; round++)
+      for (int i = 0; i < kNumSamples; i++)
+	if (db.getMovieRecord(movies[i]) == -1) misses++;
+    double end = monotonicSeconds();
+    long allocations = getAllocationCount() - allocationsBefore;
+    cout << setw(20) << names[m] << ": "
+	 << setw(12) << (long) (kNumRounds * kNumSamples / (middle - start)) << " actor lookups/sec, "
+	 << setw(12) << (long) (kNumRounds * kNumSamples / (end - middle)) << " movie lookups/sec, "
+	 << (double) allocations / (2 * kNumRounds * kNumSamples) << " allocations/lookup";
+    if (misses > 0) cout << " (" << misses << " lookups failed!)";
+    cout << endl;
+  }
+  db.setLookupMethod(imdb::INDEXED);
+
+  const int kNumCostarSamples = 100;
+  vector<imdb::costar> costars;
+  long byRecord = 0, byName = 0;
+  double start = monotonicSeconds();
+  for (int i = 0; i < kNumCostarSamples; i++) {
+    db.getCostars(players[i * kNumSamples / kNumCostarSamples], costars);
+    byRecord += costars.size();
+  }
+  double middle = monotonicSeconds();
+  for (int i = 0; i < kNumCostarSamples; i++)
+    byName += countCostarsByName(players[i * kNumSamples / kNumCostarSamples], db);
+  double end = monotonicSeconds();
+  cout << setw(20) << "costars" << ": "
+       << setw(12) << (middle - start) * 1e6 / kNumCostarSamples << " us per actor by record, "
+       << setw(12) << (end - middle) * 1e6 / kNumCostarSamples << " us per actor by name";
+  if (byRecord != byName) cout << " (the two disagree!)";
+  cout << endl;
+
+  const suggestIndex *suggestions = db.getSuggestIndex();
+  if (suggestions == NULL) {
+    cout << setw(20) << "suggestions" << ": not available (run build-index first)" << endl;
+    return;
+  }
+  vector<int> found;
+  start = monotonicSeconds();
+  for (int i = 0; i < kNumSamples; i++) suggestions->suggestByPrefix(players[i].substr(0, 4), 10, found);
+  middle = monotonicSeconds();
+  for (int i = 0; i < kNumSamples; i++) {
+    string typo = players[i];
+    if (typo.size() > 2) typo.erase(typo.size() / 2, 1);
+    suggestions->suggestSimilar(typo, 10, found);
+  }
+  end = monotonicSeconds();
+  cout << setw(20) << "suggestions" << ": "
+       << setw(12) << (middle - start) * 1e6 / kNumSamples << " us per prefix query, "
+       << setw(12) << (end - middle) * 1e6 / kNumSamples << " us per similar-name query" << endl;
+}
+
 /**
  * Function: main
  * --------------
  * Defines the entry point for the unit testing
  * program that exercises the imdb class.  Notice
  * that the imdb constructor is called, 
+ *
+ * Usage: imdb-test [--benchmark] [data-directory]
+ *
+ * With --benchmark, the lookup microbenchmark is run instead
+ * of the interactive queries.
  */
 
 int main(int argc, char **argv)
 {
-  imdb db(determinePathToData());
-  if (!db.good()) { cerr << "Data directory not found!  Aborting..." << endl; return 1; }
-  queryForActors(db);
+  bool benchmark = false;
+  const char *dataDirectory = NULL;
+  for (int i = 1; i < argc; i++) {
+    if (string(argv[i]) == "--benchmark") benchmark = true;
+    else dataDirectory = argv[i];
+  }
+
+  imdb db(determinePathToData(dataDirectory));
+  if (!db.good()) { cerr << db.getLoadErrorMessage() << "  Aborting..." << endl; return 1; }
+  if (benchmark) benchmarkLookups(db);
+  else queryForActors(db);
   return 0;
 }
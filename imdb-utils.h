@@ -6,7 +6,12 @@
 #include <iostream>
 #include <cstdlib>
 #include <cstring>
+#include <cstdio>
 #include <cctype>
+#include <fstream>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
 
 using namespace std;
 
@@ -56,13 +61,20 @@ struct film {
  * appropriate for the endianness of the system
  * 
  * Requires that the data files be stored in: ./data
+ *
+ * A single canonical copy of the data (see data-format.h and convert-data)
+ * in ./data/updated/canonical/ serves every machine and is preferred when
+ * it's there; otherwise the copy in the system's own byte order is used.
  * 
- * @return one of two data paths.
+ * @return one of three data paths.
  */
 
 inline const char *determinePathToData(const char *userSelectedPath = NULL)
 {
   if (userSelectedPath != NULL) return userSelectedPath;
+  if (access("./data/updated/canonical/actordata", R_OK) == 0 &&
+      access("./data/updated/canonical/moviedata", R_OK) == 0)
+    return "./data/updated/canonical/";
   
   //Check to see if running Windows - the directory slashes go the wrong way
   //The environment variable OS contains the operating system type on windows machines
@@ -85,4 +97,71 @@ inline const char *determinePathToData(const char *userSelectedPath = NULL)
   else return "./data/updated/big-endian/";
 }
 
+/**
+ * Returns the current reading of the monotonic clock, in seconds.
+ * Only differences between two readings are meaningful.
+ */
+
+inline double monotonicSeconds()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Asks the kernel to drop the named file's pages from the page cache, so the
+ * next process to map it starts cold.  Only clean pages are dropped, which is
+ * all a read-only data file ever has, and no privileges are needed.
+ */
+
+inline void evictFile(const string& fileName)
+{
+  int fd = open(fileName.c_str(), O_RDONLY);
+  if (fd == -1) return;
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+}
+
+/**
+ * Reads a file of actor pairs, one pair per line with the two names
+ * separated by a tab, appending each to pairs.  Lines without a tab
+ * are skipped.
+ *
+ * @return false if and only if the file couldn't be opened.
+ */
+
+inline bool readActorPairs(const char *fileName, vector<pair<string, string> >& pairs)
+{
+  ifstream in(fileName);
+  if (!in) return false;
+  string line;
+  while (getline(in, line)) {
+    size_t tab = line.find('\t');
+    if (tab == string::npos) continue;
+    pairs.push_back(make_pair(line.substr(0, tab), line.substr(tab + 1)));
+  }
+  return true;
+}
+
+/**
+ * Returns the specified text as a double-quoted JSON string, with
+ * quotes, backslashes, and control characters escaped.
+ */
+
+inline string jsonQuote(const string& text)
+{
+  string quoted = "\"";
+  for (size_t i = 0; i < text.size(); i++) {
+    unsigned char c = text[i];
+    if (c == '"' || c == '\\') { quoted += '\\'; quoted += c; }
+    else if (c < 0x20) {
+      char escape[8];
+      snprintf(escape, sizeof(escape), "\\u%04x", c);
+      quoted += escape;
+    } else quoted += c;
+  }
+  return quoted + "\"";
+}
+
 #endif
@@ -0,0 +1,99 @@
+#ifndef __imdb_views__
+#define __imdb_views__
+
+#include "imdb-utils.h"
+#include "data-format.h"
+#include <string_view>
+#include <cstring>
+using namespace std;
+
+/**
+ * Convenience struct: filmView
+ * ----------------------------
+ * The zero-copy counterpart to film: the title points directly into
+ * the mapped movie file rather than owning a copy.  It's valid for as
+ * long as the imdb it came from.
+ */
+
+struct filmView {
+  string_view title;
+  int year;
+
+  film toFilm() const {
+    film f;
+    f.title = string(title);
+    f.year = year;
+    return f;
+  }
+
+  bool operator==(const film& rhs) const { return title == rhs.title && year == rhs.year; }
+};
+
+/**
+ * Functions: decodeFilmView
+ *            decodeNameView
+ * -------------------------
+ * Decode the name (and, for movies, the year byte that follows the
+ * name's terminator) at the start of a record.
+ */
+
+inline filmView decodeFilmView(const char *record)
+{
+  filmView view;
+  size_t length = strlen(record);
+  view.title = string_view(record, length);
+  view.year = 1900 + record[length + 1];
+  return view;
+}
+
+inline string_view decodeNameView(const char *record)
+{
+  return string_view(record);
+}
+
+/**
+ * Class: recordList
+ * -----------------
+ * A lightweight, read-only range over the offset array stored inside an
+ * actor or movie record.  Each element is decoded on the fly from the
+ * record it refers to in the other file, so iterating copies nothing.
+ * Instances are cheap to copy, and valid for as long as the imdb they came
+ * from.  Clients use the creditList and castList typedefs below.
+ */
+
+template <typename View, View (*decode)(const char *)>
+class recordList {
+ public:
+  class iterator {
+   public:
+    iterator(const char *file, const int *pos) : file(file), pos(pos) {}
+    View operator*() const { return decode(file + readLittleInt(pos)); }
+    iterator& operator++() { ++pos; return *this; }
+    bool operator==(const iterator& rhs) const { return pos == rhs.pos; }
+    bool operator!=(const iterator& rhs) const { return pos != rhs.pos; }
+    int record() const { return readLittleInt(pos); } // offset of the current record
+   private:
+    const char *file;
+    const int *pos;
+  };
+
+  recordList() : file(NULL), offsets(NULL), count(0) {}
+  recordList(const void *file, const int *offsets, int count) :
+    file((const char *) file), offsets(offsets), count(count) {}
+
+  iterator begin() const { return iterator(file, offsets); }
+  iterator end() const { return iterator(file, offsets + count); }
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  View operator[](size_t i) const { return decode(file + readLittleInt(offsets + i)); }
+
+ private:
+  const char *file;
+  const int *offsets;
+  int count;
+};
+
+typedef recordList<filmView, decodeFilmView> creditList;
+typedef recordList<string_view, decodeNameView> castList;
+
+#endif
@@ -5,10 +5,24 @@ using namespace std;
 #include <fcntl.h>
 #include <unistd.h>
 #include <cassert>
+#include <cstdio>
+#include <stdint.h>
+#include <cstring>
+#include <algorithm>
 #include "imdb.h"
+#include "record-set.h"
+#include "data-format.h"
+#include "query-profile.h"
 
 const char *const imdb::kActorFileName = "actordata";
 const char *const imdb::kMovieFileName = "moviedata";
+const char *const imdb::kActorIndexFileName = "actorindex";
+const char *const imdb::kMovieIndexFileName = "movieindex";
+const char *const imdb::kGraphFileName = "graphdata";
+const char *const imdb::kCostarFileName = "costardata";
+const char *const imdb::kLabelFileName = "labeldata";
+const char *const imdb::kStampFileName = "validated";
+const char *const imdb::kSuggestFileName = "actorsuggest";
 
 /**
  * Convenience struct for passing in a key to bsearch that contains both 
@@ -41,41 +55,12 @@ struct fRecord {
 		 *
 		 *  e.g. for actor records, the base of the array of offsets into
 		 *  the movie file for the movies that the referenced actor
-		 *  appeared in
+		 *  appeared in.  Its elements are little-endian, so read them
+		 *  with readLittleInt.
 		 */
 };
 
 
-/**
- * Helper method for getRecord.
- *
- * @param type An int representing the type of record (actor or movie) - use
- * imdb class defined constants ACTOR and MOVIE when passing in values
- *
- * @param nameLength The length of the name of the actor or movie associated
- * with the record
- *
- * @return the padding needed to be added to the length of the name of the
- * movie or actor to produce an appropriate offset from the base of a record
- * to access the number of elements within the array of offsets held within
- * the record
- */
-
-size_t getShortPadding(int type, size_t nameLength){
-  size_t padding;
-  if(type == imdb::ACTOR){
-    if(nameLength % 2 == 1) padding = 1;
-    else padding = 2;
-  } else if(type == imdb::MOVIE){
-    if(nameLength % 2 == 1) padding = 3;
-    else padding = 2;
-  } else {
-    assert(type == imdb::ACTOR || type == imdb::MOVIE);
-  }
-  return padding;
-}
-
-
 /**
  * Retrieves records from a data file
  *
@@ -92,6 +77,7 @@ size_t getShortPadding(int type, size_t nameLength){
  */
 
 fRecord getRecord(const void* file, size_t offset, int type){
+  PROFILE_COUNT(PROFILE_RECORDS_DECODED);
   fRecord found;
   char* name = (char*)file + offset;
   size_t nameLength = strlen(name);
@@ -99,7 +85,7 @@ fRecord getRecord(const void* file, size_t offset, int type){
   found.year = 1900 + *(name + nameLength + 1); // Year will be nonsensical for actors
   size_t padding = getShortPadding(type, nameLength);
   short* numContentsPtr = (short*)(name + nameLength + padding);
-  found.numContents = *numContentsPtr;
+  found.numContents = readLittleShort(numContentsPtr);
     
   int numBytes = (char*)(numContentsPtr) + 2 - name;
   if(numBytes % 4 == 0) padding = 0;
@@ -141,12 +127,12 @@ film filmFromRecord(const fRecord& rec){
  */
 
 int compareActors(const void* pkey, const void* pelem){
+  PROFILE_COUNT(PROFILE_BSEARCH_PROBES);
   bsearchKey* bskey = (bsearchKey*)pkey; // Cast the pkey void* to a bsearchKey*
   char* actorNameKey = (char*)bskey->key; // Get the actors name from the key
   const void* actorFile = bskey->file; // Get the base of the actor file from the key
-  int offset = *(int*)pelem; // Get the int offset from the array within the file
+  int offset = readLittleInt(pelem); // Get the int offset from the array within the file
   char* foundNameKey = getRecord(actorFile,(size_t)offset, imdb::ACTOR).name;
-  cout << "Searching for " << actorNameKey << ", found " << foundNameKey << endl;
   return strcmp(actorNameKey, foundNameKey);
 }
 
@@ -167,43 +153,281 @@ int compareActors(const void* pkey, const void* pelem){
  */
 
 int compareMovies(const void* pkey, const void* pelem){
+  PROFILE_COUNT(PROFILE_BSEARCH_PROBES);
   bsearchKey* bskey = (bsearchKey*)pkey;
   film* filmKeyPtr = (film*)bskey->key;
   const void* movieFile = bskey->file;
-  int offset = *(int*)pelem;
+  int offset = readLittleInt(pelem);
   film foundFilm = filmFromRecord(getRecord(movieFile, (size_t)offset,imdb::MOVIE));
   if (*filmKeyPtr == foundFilm) return 0;
   if (*filmKeyPtr < foundFilm) return -1;
   else return 1;
 }
 
+/**
+ * The fast counterpart to compareActors.  It compares the key directly
+ * against the name at the start of the record, without decoding the
+ * rest of the record.
+ *
+ * @param pkey A pointer to a bsearchKey struct, exactly as for compareActors
+ * @param pelem A pointer to the element being inspected within an array of int offsets
+ * @return an int following the comparison function paradigm
+ */
+
+int compareActorsInPlace(const void* pkey, const void* pelem){
+  PROFILE_COUNT(PROFILE_BSEARCH_PROBES);
+  const bsearchKey* bskey = (const bsearchKey*)pkey;
+  return strcmp((const char*)bskey->key, (const char*)bskey->file + readLittleInt(pelem));
+}
+
+/**
+ * The fast counterpart to compareMovies.  The title is compared in place
+ * against the record, byte by byte, and only if the titles match is the year
+ * byte that follows the title's terminator compared, so no film (and no
+ * string) is ever constructed.
+ *
+ * @param pkey A pointer to a bsearchKey struct, exactly as for compareMovies
+ * @param pelem A pointer to the element being inspected within an array of int offsets
+ * @return an int following the comparison function paradigm
+ */
+
+int compareMoviesInPlace(const void* pkey, const void* pelem){
+  PROFILE_COUNT(PROFILE_BSEARCH_PROBES);
+  const bsearchKey* bskey = (const bsearchKey*)pkey;
+  const film* filmKeyPtr = (const film*)bskey->key;
+  const unsigned char* key = (const unsigned char*)filmKeyPtr->title.c_str();
+  const unsigned char* found = (const unsigned char*)bskey->file + readLittleInt(pelem);
+  while (*key != '\0' && *key == *found) { key++; found++; }
+  if (*key != *found) return (int)*key - (int)*found;
+  return filmKeyPtr->year - (1900 + *(const char*)(found + 1));
+}
+
+
+
+/**
+ * Checks the offset table and every record of one data file without trusting
+ * anything in it: the table has to fit in the file, every offset has to be
+ * aligned and land past the table, and every record's name, count, and offset
+ * array have to end before the file does.  The table also has to be sorted,
+ * since every lookup binary searches it.  The offsets of the records are
+ * collected in records, for checkContents.
+ *
+ * @return the empty string if the file is well formed, or else a description
+ *         of the first problem found.
+ */
+
+static string checkRecords(const void* file, size_t fileSize, int type, recordSet& records){
+  const char* base = (const char*)file;
+  if (fileSize < sizeof(int)) return "is too short to hold an offset table";
+  int numRecords = readLittleInt(base);
+  size_t recordsStart = sizeof(int) * (1 + (size_t)numRecords);
+  if (numRecords < 0 || recordsStart > fileSize) return "has an offset table that runs past its end";
+  const int* table = (const int*)base + 1;
+  for (int i = 0; i < numRecords; i++) {
+    string where = "record " + to_string(i);
+    int offset = readLittleInt(table + i);
+    if (offset < (long)recordsStart || (size_t)offset >= fileSize || offset % imdb::kRecordAlignment != 0)
+      return "has an offset table entry for " + where + " that lies outside the records";
+    const char* name = base + offset;
+    const char* end = (const char*)memchr(name, '\0', fileSize - offset);
+    if (end == NULL) return "has a name in " + where + " that runs past its end";
+    size_t nameLength = end - name;
+    size_t countAt = offset + nameLength + getShortPadding(type, nameLength);
+    if (countAt + sizeof(short) > fileSize) return "has " + where + " truncated at its end";
+    short numContents = readLittleShort(base + countAt);
+    size_t arrayAt = countAt + sizeof(short);
+    if ((arrayAt - offset) % 4 != 0) arrayAt += 2;
+    if (numContents < 0 || arrayAt + numContents * sizeof(int) > fileSize)
+      return "has an offset array in " + where + " that runs past its end";
+    if (i > 0) {
+      const char* previous = base + readLittleInt(table + i - 1);
+      int order = strcmp(previous, name);
+      if (order == 0 && type == imdb::MOVIE)
+	order = *(previous + nameLength + 1) - *(name + nameLength + 1);
+      if (order > 0) return "has an offset table that isn't sorted at " + where;
+    }
+    records.insert(offset);
+  }
+  return "";
+}
+
+/**
+ * The second half of validation, run once both files' records are known to
+ * be well formed: every offset in every record of one file has to be the
+ * offset of a record of the other.
+ *
+ * @param others the records of the other file, as collected by checkRecords.
+ * @return the empty string if every offset checks out, or else a description
+ *         of the first that doesn't.
+ */
+
+static string checkContents(const void* file, int type, const recordSet& others, size_t otherSize){
+  int numRecords = readLittleInt(file);
+  const int* table = (const int*)file + 1;
+  for (int i = 0; i < numRecords; i++) {
+    fRecord rec = getRecord(file, readLittleInt(table + i), type);
+    for (int j = 0; j < rec.numContents; j++) {
+      int offset = readLittleInt(rec.offsets + j);
+      if (offset < 0 || (size_t)offset >= otherSize || !others.contains(offset))
+	return "has record " + to_string(i) + " naming something that isn't in " +
+	  (type == imdb::ACTOR ? "moviedata" : "actordata");
+    }
+  }
+  return "";
+}
+
+/**
+ * The stamp (see dataStamp) checksums just the offset tables, so computing
+ * it touches a small fraction of either file.  The stamp of a pair of files
+ * that passed validation is what's cached in the validated sidecar.
+ */
+
+static const uint64_t kStampMagic = 0x64696c6176626d69ULL; // "imbvalid"
+
+static uint64_t checksumTable(const void* file, uint64_t hash){
+  const unsigned char* bytes = (const unsigned char*)file;
+  size_t length = sizeof(int) * (1 + (size_t)readLittleInt(file));
+  for (size_t i = 0; i < length; i++) hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+  return hash;
+}
+
+/**
+ * st_mtim, and with it the nanoseconds of a modification time, is only
+ * reliably there on Linux; elsewhere (Solaris, say) the stamp makes do with
+ * whole seconds.
+ */
+
+static uint64_t modificationNanoseconds(const struct stat& stats){
+#ifdef __linux__
+  return stats.st_mtim.tv_nsec;
+#else
+  (void) stats;
+  return 0;
+#endif
+}
 
+static void computeStamp(int actorFd, const void* actorFile, int movieFd, const void* movieFile,
+			 uint64_t stamp[dataStamp::kWords]){
+  struct stat actorStats, movieStats;
+  fstat(actorFd, &actorStats);
+  fstat(movieFd, &movieStats);
+  stamp[0] = kStampMagic;
+  stamp[1] = actorStats.st_size;
+  stamp[2] = actorStats.st_mtime;
+  stamp[3] = modificationNanoseconds(actorStats);
+  stamp[4] = movieStats.st_size;
+  stamp[5] = movieStats.st_mtime;
+  stamp[6] = modificationNanoseconds(movieStats);
+  stamp[7] = checksumTable(movieFile, checksumTable(actorFile, 0xcbf29ce484222325ULL));
+}
+
+/**
+ * Sizes are checked before the stamp is computed, since the checksum reads
+ * the offset tables.  Failing to write the stamp (to a read-only directory,
+ * say) only means the next imdb validates the files again.
+ */
 
-imdb::imdb(const string& directory)
+bool imdb::validateFiles(const string& stampFileName)
+{
+  if (actorInfo.fileSize < sizeof(int) || movieInfo.fileSize < sizeof(int) ||
+      sizeof(int) * (1 + (size_t)readLittleInt(actorFile)) > actorInfo.fileSize ||
+      sizeof(int) * (1 + (size_t)readLittleInt(movieFile)) > movieInfo.fileSize) {
+    loadError = MALFORMED_FILE;
+    loadErrorMessage = "A data file is too short to hold its own offset table.";
+    return false;
+  }
+
+  uint64_t* stamp = this->stamp.words;
+  uint64_t cached[dataStamp::kWords];
+  computeStamp(actorInfo.fd, actorFile, movieInfo.fd, movieFile, stamp);
+  FILE* in = fopen(stampFileName.c_str(), "rb");
+  if (in != NULL) {
+    bool matches = fread(cached, sizeof(uint64_t), dataStamp::kWords, in) == (size_t)dataStamp::kWords &&
+      memcmp(cached, stamp, sizeof(cached)) == 0;
+    fclose(in);
+    if (matches) return true;
+  }
+
+  recordSet actors(actorInfo.fileSize), movies(movieInfo.fileSize);
+  string problem = checkRecords(actorFile, actorInfo.fileSize, ACTOR, actors);
+  string fileName = kActorFileName;
+  if (problem.empty()) {
+    problem = checkRecords(movieFile, movieInfo.fileSize, MOVIE, movies);
+    fileName = kMovieFileName;
+  }
+  if (problem.empty()) {
+    problem = checkContents(actorFile, ACTOR, movies, movieInfo.fileSize);
+    fileName = kActorFileName;
+  }
+  if (problem.empty()) {
+    problem = checkContents(movieFile, MOVIE, actors, actorInfo.fileSize);
+    fileName = kMovieFileName;
+  }
+  if (!problem.empty()) {
+    loadError = MALFORMED_FILE;
+    loadErrorMessage = fileName + " " + problem + ".";
+    return false;
+  }
+
+  FILE* out = fopen(stampFileName.c_str(), "wb");
+  if (out != NULL) {
+    fwrite(stamp, sizeof(uint64_t), dataStamp::kWords, out);
+    fclose(out);
+  }
+  return true;
+}
+
+static string describeMapError(int error, const string& fileName){
+  if (error == imdb::LEGACY_FILE)
+    return fileName + " is a legacy data file, which only little-endian machines read; convert it with convert-data.";
+  if (error == imdb::MALFORMED_FILE)
+    return fileName + " has a header this reader doesn't understand, or records that run past its end.";
+  return "Couldn't open or map " + fileName + ".";
+}
+
+imdb::imdb(const string& directory, int mapOptions) :
+  lookupMethod(INDEXED), mapOptions(mapOptions), loadError(LOAD_OK)
 {
   const string actorFileName = directory + "/" + kActorFileName;
   const string movieFileName = directory + "/" + kMovieFileName;
   
-  actorFile = acquireFileMap(actorFileName, actorInfo);
-  movieFile = acquireFileMap(movieFileName, movieInfo);
+  loadError = acquireFileMap(actorFileName, actorInfo, this->mapOptions, ACTOR);
+  if (loadError != LOAD_OK) loadErrorMessage = describeMapError(loadError, actorFileName);
+  int movieError = acquireFileMap(movieFileName, movieInfo, this->mapOptions, MOVIE);
+  if (loadError == LOAD_OK && movieError != LOAD_OK) {
+    loadError = movieError;
+    loadErrorMessage = describeMapError(movieError, movieFileName);
+  }
+  actorFile = actorInfo.fileMap;
+  movieFile = movieInfo.fileMap;
+  if (loadError == LOAD_OK) validateFiles(directory + "/" + kStampFileName);
+  if (good()) {
+    actorIndex.load(directory + "/" + kActorIndexFileName, actorInfo.fileSize, stamp);
+    movieIndex.load(directory + "/" + kMovieIndexFileName, movieInfo.fileSize, stamp);
+    suggestions.load(directory + "/" + kSuggestFileName, actorInfo.fileSize, stamp);
+    if (graph.load(directory + "/" + kGraphFileName, actorInfo.fileSize, movieInfo.fileSize, stamp)) {
+      costars.load(directory + "/" + kCostarFileName, actorInfo.fileSize, movieInfo.fileSize, stamp);
+      labels.load(directory + "/" + kLabelFileName, actorInfo.fileSize, movieInfo.fileSize, stamp);
+    }
+  }
 }
 
 bool imdb::good() const
 {
-  return !( (actorInfo.fd == -1) || 
-	    (movieInfo.fd == -1) ); 
+  return loadError == LOAD_OK;
 }
 
 
 
 
 bool imdb::getCredits(const string& player, vector<film>& films) const { 
-  int* foundID = searchFile(player.c_str(), actorFile, compareActors);
-  if (foundID == NULL) return false;
-  fRecord rec = getRecord(actorFile,*foundID, ACTOR);
-  assert(strcmp(rec.name,player.c_str()) == 0);
+  PROFILE_STAGE(STAGE_CREDITS);
+  int foundID = getActorRecord(player);
+  if (foundID == -1) return false;
+  fRecord rec = getRecord(actorFile, foundID, ACTOR);
+  PROFILE_ADD(PROFILE_STRINGS_BUILT, rec.numContents);
   for (int i = 0; i  < rec.numContents; i++)
-    films.push_back(filmFromRecord(getRecord(movieFile,rec.offsets[i],MOVIE)));
+    films.push_back(filmFromRecord(getRecord(movieFile,readLittleInt(rec.offsets + i),MOVIE)));
   return true; 
 }
 
@@ -212,22 +436,157 @@ bool imdb::getCredits(const string& player, vector<film>& films) const {
 
 
 bool imdb::getCast(const film& movie, vector<string>& players) const { 
-  int* foundID = searchFile(&movie, movieFile, compareMovies);
-  if (foundID == NULL) return false;
-  fRecord rec = getRecord(movieFile, *foundID, MOVIE);
-  film foundFilm = filmFromRecord(rec);
-  assert(foundFilm == movie);
+  PROFILE_STAGE(STAGE_CREDITS);
+  int foundID = getMovieRecord(movie);
+  if (foundID == -1) return false;
+  fRecord rec = getRecord(movieFile, foundID, MOVIE);
+  PROFILE_ADD(PROFILE_STRINGS_BUILT, rec.numContents);
   for(int i = 0; i < rec.numContents; i++)
-    players.push_back(getRecord(actorFile,rec.offsets[i],ACTOR).name);
+    players.push_back(getRecord(actorFile,readLittleInt(rec.offsets + i),ACTOR).name);
   return true; 
 }
 
 
+/**
+ * With a name index loaded, the only probe into the data file is the one
+ * confirming that the record in the key's slot really is the key.
+ */
+
+int imdb::getActorRecord(const string& player) const {
+  PROFILE_COUNT(PROFILE_LOOKUPS);
+  PROFILE_STAGE(STAGE_LOOKUP);
+  if (lookupMethod == INDEXED && actorIndex.good()) {
+    int candidate = actorIndex.lookup(nameIndex::hashActor(player.c_str()));
+    return strcmp((char*)actorFile + candidate, player.c_str()) == 0 ? candidate : -1;
+  }
+  int* foundID = searchFile(player.c_str(), actorFile,
+			    lookupMethod == REFERENCE_BSEARCH ? compareActors : compareActorsInPlace);
+  return foundID == NULL ? -1 : readLittleInt(foundID);
+}
+
+int imdb::getMovieRecord(const film& movie) const {
+  PROFILE_COUNT(PROFILE_LOOKUPS);
+  PROFILE_STAGE(STAGE_LOOKUP);
+  if (lookupMethod == INDEXED && movieIndex.good()) {
+    int candidate = movieIndex.lookup(nameIndex::hashMovie(movie.title.c_str(), movie.year));
+    const char* title = (char*)movieFile + candidate;
+    return (strcmp(title, movie.title.c_str()) == 0 &&
+	    1900 + *(title + strlen(title) + 1) == movie.year) ? candidate : -1;
+  }
+  int* foundID = searchFile(&movie, movieFile,
+			    lookupMethod == REFERENCE_BSEARCH ? compareMovies : compareMoviesInPlace);
+  return foundID == NULL ? -1 : readLittleInt(foundID);
+}
+
+int imdb::getCreditRecords(int actorRecord, offsetArray& movieRecords) const {
+  fRecord rec = getRecord(actorFile, actorRecord, ACTOR);
+  movieRecords = offsetArray(rec.offsets);
+  return rec.numContents;
+}
+
+int imdb::getCastRecords(int movieRecord, offsetArray& actorRecords) const {
+  fRecord rec = getRecord(movieFile, movieRecord, MOVIE);
+  actorRecords = offsetArray(rec.offsets);
+  return rec.numContents;
+}
+
+bool imdb::getCostars(const string& player, vector<costar>& costars) const {
+  int actorRecord = getActorRecord(player);
+  if (actorRecord == -1) { costars.clear(); return false; }
+  getCostarRecords(actorRecord, costars);
+  return true;
+}
+
+int imdb::getCostarRecords(int actorRecord, vector<costar>& costars) const {
+  costars.clear();
+  vector<uint64_t> pairs;
+  offsetArray movies;
+  int numMovies = getCreditRecords(actorRecord, movies);
+  for (int i = 0; i < numMovies; i++) {
+    offsetArray cast;
+    int castSize = getCastRecords(movies[i], cast);
+    for (int j = 0; j < castSize; j++)
+      if (cast[j] != actorRecord)
+	pairs.push_back((uint64_t) (uint32_t) cast[j] << 32 | (uint32_t) movies[i]);
+  }
+  sort(pairs.begin(), pairs.end());
+  pairs.erase(unique(pairs.begin(), pairs.end()), pairs.end());
+
+  for (size_t i = 0; i < pairs.size(); ) {
+    size_t j = i + 1;
+    while (j < pairs.size() && pairs[j] >> 32 == pairs[i] >> 32) j++;
+    costar entry = { (int) (pairs[i] >> 32), (int) (j - i) };
+    costars.push_back(entry);
+    i = j;
+  }
+  const char *names = (const char *) actorFile;
+  sort(costars.begin(), costars.end(), [names](const costar& one, const costar& two) {
+    return strcmp(names + one.actor, names + two.actor) < 0;
+  });
+  return costars.size();
+}
+
+string imdb::getActorName(int actorRecord) const {
+  PROFILE_COUNT(PROFILE_STRINGS_BUILT);
+  return (char*)actorFile + actorRecord;
+}
+
+film imdb::getMovie(int movieRecord) const {
+  PROFILE_COUNT(PROFILE_STRINGS_BUILT);
+  return filmFromRecord(getRecord(movieFile, movieRecord, MOVIE));
+}
+
+int imdb::getMovieYear(int movieRecord) const {
+  const char *title = (const char *) movieFile + movieRecord;
+  return 1900 + *(title + strlen(title) + 1);
+}
+
+int imdb::getNumActors() const {
+  return readLittleInt(actorFile);
+}
+
+int imdb::getNumMovies() const {
+  return readLittleInt(movieFile);
+}
+
+int imdb::getActorRecordAt(int index) const {
+  return readLittleInt((const int*)actorFile + 1 + index);
+}
+
+int imdb::getMovieRecordAt(int index) const {
+  return readLittleInt((const int*)movieFile + 1 + index);
+}
+
+bool imdb::setLookupMethod(int method) {
+  lookupMethod = method;
+  return method != INDEXED || (actorIndex.good() && movieIndex.good());
+}
+
+size_t imdb::getFileSize(int type) const {
+  return type == ACTOR ? actorInfo.fileSize : movieInfo.fileSize;
+}
+
+bool imdb::getCredits(const string& player, creditList& films) const {
+  int foundID = getActorRecord(player);
+  if (foundID == -1) { films = creditList(); return false; }
+  fRecord rec = getRecord(actorFile, foundID, ACTOR);
+  films = creditList(movieFile, rec.offsets, rec.numContents);
+  return true;
+}
+
+bool imdb::getCast(const film& movie, castList& players) const {
+  int foundID = getMovieRecord(movie);
+  if (foundID == -1) { players = castList(); return false; }
+  fRecord rec = getRecord(movieFile, foundID, MOVIE);
+  players = castList(actorFile, rec.offsets, rec.numContents);
+  return true;
+}
+
 int* imdb::searchFile(const void* key, const void* file, int (*cmpr)(const void*, const void*)){
   bsearchKey bskey;
   bskey.file = file;
   bskey.key = key;
-  int numElems = *(int*)file;
+  int numElems = readLittleInt(file);
   int* base = (int*)file + 1;
   return (int*)bsearch(&bskey, base, numElems, sizeof(int), cmpr);
 }
@@ -249,17 +608,87 @@ imdb::~imdb()
 
 // ignore everything below... it's all UNIXy stuff in place to make a file look like
 // an array of bytes in RAM.. 
-const void *imdb::acquireFileMap(const string& fileName, struct fileInfo& info)
+/**
+ * Reads the header of a canonical data file (see data-format.h), if the
+ * mapped file begins with one.  The header is little-endian, like the rest
+ * of the file, so big-endian builds swap its fields as they decode it.
+ *
+ * @return 1 if the file is canonical and its header checks out (header is then
+ *         decoded into native order), 0 if it's a legacy file with no header,
+ *         and -1 if it has a header this reader can't use, or one whose
+ *         payload size or record count disagrees with the payload itself.
+ */
+
+static int readDataFileHeader(const void* map, size_t mapSize, int type, dataFileHeader& header){
+  if (mapSize < sizeof(header)) return 0;
+  memcpy(&header, map, sizeof(header));
+  if (memcmp(header.magic, kDataMagic, sizeof(kDataMagic)) != 0) return 0;
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+  header.version = __builtin_bswap32(header.version);
+  header.byteOrder = __builtin_bswap32(header.byteOrder);
+  header.type = __builtin_bswap32(header.type);
+  header.numRecords = __builtin_bswap32(header.numRecords);
+  header.payloadSize = __builtin_bswap64(header.payloadSize);
+#endif
+  if (header.byteOrder != kByteOrderMark || header.version != kDataVersion ||
+      header.type != (uint32_t)type || header.payloadSize != mapSize - sizeof(header) ||
+      header.payloadSize < sizeof(int)) return -1;
+  if ((uint32_t) readLittleInt((const char *) map + sizeof(header)) != header.numRecords) return -1;
+  return 1;
+}
+
+/**
+ * Huge pages have to be asked for before any page is faulted in, so when
+ * they're wanted, MAP_POPULATE is held back and the pages are prefaulted by
+ * hand after the madvise.  Any option that fails is cleared from options.
+ *
+ * A canonical file is used where it's mapped, shared with every other process
+ * reading it, with fileMap pointing just past the header; its little-endian
+ * fields are read through readLittleInt and readLittleShort.  A legacy file
+ * is in whatever byte order it was written in, which only little-endian
+ * builds assume, so big-endian builds turn legacy files away.
+ */
+
+int imdb::acquireFileMap(const string& fileName, struct fileInfo& info, int& options, int type)
 {
-  struct stat stats;
-  stat(fileName.c_str(), &stats);
-  info.fileSize = stats.st_size;
+  info.fileSize = info.mapSize = 0;
+  info.fileMap = info.mapBase = NULL;
   info.fd = open(fileName.c_str(), O_RDONLY);
-  return info.fileMap = mmap(0, info.fileSize, PROT_READ, MAP_SHARED, info.fd, 0);
+  if (info.fd == -1) return MISSING_FILE;
+  struct stat stats;
+  if (fstat(info.fd, &stats) == -1 || !S_ISREG(stats.st_mode) || stats.st_size == 0)
+    return UNMAPPABLE_FILE;
+  info.mapSize = stats.st_size;
+  int flags = MAP_SHARED;
+  if ((options & PREFAULT) && !(options & HUGE_PAGES)) flags |= MAP_POPULATE;
+  void *map = mmap(0, info.mapSize, PROT_READ, flags, info.fd, 0);
+  if (map == MAP_FAILED) return UNMAPPABLE_FILE;
+  info.mapBase = map;
+
+  dataFileHeader header;
+  int format = readDataFileHeader(map, info.mapSize, type, header);
+  if (format == -1) return MALFORMED_FILE;
+  if (format == 0 && !kNativeLittleEndian) return LEGACY_FILE;
+  size_t headerSize = format == 1 ? sizeof(header) : 0;
+  info.fileMap = (const char *) map + headerSize;
+  info.fileSize = info.mapSize - headerSize;
+
+  if ((options & HUGE_PAGES) && madvise((void *) info.mapBase, info.mapSize, MADV_HUGEPAGE) != 0)
+    options &= ~HUGE_PAGES;
+  if ((options & PREFAULT) && !(flags & MAP_POPULATE)) {
+    madvise((void *) info.mapBase, info.mapSize, MADV_WILLNEED);
+    long pageSize = sysconf(_SC_PAGESIZE);
+    volatile char sink = 0;
+    for (size_t offset = 0; offset < info.mapSize; offset += pageSize)
+      sink += ((const char *) info.mapBase)[offset];
+  }
+  if ((options & LOCK_PAGES) && mlock(info.mapBase, info.mapSize) != 0)
+    options &= ~LOCK_PAGES;
+  return LOAD_OK;
 }
 
 void imdb::releaseFileMap(struct fileInfo& info)
 {
-  if (info.fileMap != NULL) munmap((char *) info.fileMap, info.fileSize);
+  if (info.mapBase != NULL) munmap((char *) info.mapBase, info.mapSize);
   if (info.fd != -1) close(info.fd);
 }
@@ -2,6 +2,13 @@
 #define __imdb__
 
 #include "imdb-utils.h"
+#include "data-format.h"
+#include "name-index.h"
+#include "imdb-views.h"
+#include "imdb-graph.h"
+#include "costar-graph.h"
+#include "distance-oracle.h"
+#include "suggest-index.h"
 #include <string>
 #include <vector>
 using namespace std;
@@ -19,12 +26,30 @@ class imdb {
    * stored in the specified directory.  The understanding is that the specified
    * directory contains binary files carefully formatted to compactly store
    * all of the information about the movies and actors relevant to an IMDB
-   * application (like six-degrees).
+   * application (like six-degrees).  If the directory also holds name index
+   * sidecar files built by build-index, they're used to look names up in
+   * constant time; otherwise names are found by binary search.  Likewise, a
+   * graph snapshot built by build-graph is loaded if present (see getGraph).
+   *
+   * By default the data files are mapped lazily, so the first queries fault
+   * in whichever pages they touch.  mapOptions combines any of
+   *
+   *     PREFAULT     read both files in and map every page up front
+   *     LOCK_PAGES   lock both files in memory (mlock), so no page is ever evicted
+   *     HUGE_PAGES   ask for transparent huge pages, where the kernel supports
+   *                  them for file mappings
+   *
+   * to move that cost into the constructor instead.  Options the system refuses
+   * are dropped quietly; getMapOptions reports the ones that took effect.
    *
    * @param directory the name of the directory housing the formatted information backing the imdb.
+   * @param mapOptions a bitwise or of the options above, or 0.
    */
 
-  imdb(const string& directory);
+  static const int PREFAULT = 1;
+  static const int LOCK_PAGES = 2;
+  static const int HUGE_PAGES = 4;
+  imdb(const string& directory, int mapOptions = 0);
 
   /**
    * Predicate Method: good
@@ -35,10 +60,45 @@ class imdb {
    *     1.) either one or both of the data files supporting the imdb were missing
    *     2.) the directory passed to the constructor doesn't exist.
    *     3.) the directory and files all exist, but you don't have the permission to read them.
+   *     4.) a data file is truncated or corrupt (see getLoadError).
    */
 
   bool good() const;
 
+  /**
+   * Methods: getLoadError
+   *          getLoadErrorMessage
+   * ----------------------------
+   * Explain why good() returned false.  getLoadError returns one of
+   *
+   *     LOAD_OK           both files were mapped and are well formed
+   *     MISSING_FILE      a data file doesn't exist or couldn't be opened
+   *     UNMAPPABLE_FILE   a data file couldn't be examined or mapped into memory
+   *     MALFORMED_FILE    a data file failed validation: its offset table or one of
+   *                       its records runs past the end of the file, a record names
+   *                       something that isn't a record of the other file, or the
+   *                       offset table isn't sorted
+   *     LEGACY_FILE       a data file has no canonical header, and this is a
+   *                       big-endian build, which reads only canonical files
+   *
+   * and getLoadErrorMessage a sentence naming the file and the problem.
+   *
+   * Validation is one linear pass over both files, run the first time a pair
+   * of files is opened.  Afterwards a stamp recording the files' sizes and
+   * modification times and a checksum of their offset tables is left behind as
+   * a sidecar named validated, and later imdbs whose files still match it skip
+   * the pass.  Every other method assumes the files are well formed and does
+   * no bounds checking of its own.
+   */
+
+  static const int LOAD_OK = 0;
+  static const int MISSING_FILE = 1;
+  static const int UNMAPPABLE_FILE = 2;
+  static const int MALFORMED_FILE = 3;
+  static const int LEGACY_FILE = 4;
+  int getLoadError() const { return loadError; }
+  const string& getLoadErrorMessage() const { return loadErrorMessage; }
+
   /**
    * Method: getCredits
    * ------------------
@@ -54,7 +114,7 @@ class imdb {
    *              database, and false otherwise.
    */
 
-  bool getCredits(const string& player, vector<film>& films) const;
+  virtual bool getCredits(const string& player, vector<film>& films) const;
 
   /**
    * Method: getCast
@@ -74,23 +134,246 @@ class imdb {
    *              database, and false otherwise.
    */
 
-  bool getCast(const film& movie, vector<string>& players) const;
+  virtual bool getCast(const film& movie, vector<string>& players) const;
+
+  /**
+   * Methods: getCredits
+   *          getCast
+   * ------------------
+   * Zero-copy overloads of the two methods above.  Rather than copying every
+   * title or name out of the data files, they hand back a creditList of
+   * filmViews or a castList of string_views pointing straight into the mapped
+   * files (see imdb-views.h).  The views stay valid for the lifetime of the imdb.
+   *
+   * @param player/movie the actor/actress or film being queried.
+   * @param films/players set to the range of credits or cast members, or to
+   *                      an empty range if the player or movie isn't in the database.
+   * @return true if and only if the player or movie appeared in the database.
+   */
+
+  bool getCredits(const string& player, creditList& films) const;
+  bool getCast(const film& movie, castList& players) const;
+
+  /**
+   * Methods: getActorRecord
+   *          getMovieRecord
+   * -----------------------
+   * Looks up the specified actor/actress or movie and returns the byte offset
+   * of its record within the actor or movie file.  Record offsets are a compact,
+   * allocation-free stand-in for names and films, and can be fed to the other
+   * record-level methods below.  Every record begins on a kRecordAlignment
+   * boundary, so offset / kRecordAlignment numbers the records of a file densely
+   * enough to index a bitset (see getFileSize).
+   *
+   * @return the offset of the matching record, or -1 if there isn't one.
+   */
+
+  static const int kRecordAlignment = 4;
+  int getActorRecord(const string& player) const;
+  int getMovieRecord(const film& movie) const;
+
+  /**
+   * Methods: getCreditRecords
+   *          getCastRecords
+   * -----------------------
+   * Exposes the offset array stored inside an actor (or movie) record, which
+   * lists the offsets of the movies that actor appeared in (or of the actors
+   * in that movie's cast).  The array lives inside the mapped file, so it
+   * remains valid for as long as the imdb does.  It's an offsetArray (see
+   * data-format.h): index it, but don't dereference or offset it.
+   *
+   * @param actorRecord/movieRecord the offset of the record being expanded.
+   * @param movieRecords/actorRecords set to the base of the offset array.
+   * @return the number of offsets in the array.
+   */
+
+  int getCreditRecords(int actorRecord, offsetArray& movieRecords) const;
+  int getCastRecords(int movieRecord, offsetArray& actorRecords) const;
+
+  /**
+   * Methods: getCostars
+   *          getCostarRecords
+   * -------------------------
+   * Collects everyone who has appeared in a movie with the specified
+   * actor/actress, along with the number of films each of them shares with
+   * that actor.  Co-stars are aggregated by record offset: every (co-star,
+   * movie) pair is packed into one 64-bit key, the keys are sorted, duplicates
+   * dropped, and runs counted, so no names or films are built.  The result is
+   * left in order of name (compared in place in the mapped file), and names
+   * are only materialized for the entries a client chooses to print.
+   *
+   * @param player/actorRecord the actor/actress whose co-stars are wanted.
+   * @param costars cleared, then filled with one entry per co-star.
+   * @return true if and only if the player appeared in the database (getCostars),
+   *         or the number of co-stars found (getCostarRecords).
+   */
+
+  struct costar {
+    int actor;        /// the co-star's record
+    int sharedFilms;  /// the number of different films the two appeared in together
+  };
+
+  bool getCostars(const string& player, vector<costar>& costars) const;
+  int getCostarRecords(int actorRecord, vector<costar>& costars) const;
+
+  /**
+   * Methods: getActorName
+   *          getMovie
+   * -----------------
+   * Converts a record offset back into the name or film it describes.
+   */
+
+  string getActorName(int actorRecord) const;
+  film getMovie(int movieRecord) const;
+
+  /**
+   * Method: getMovieYear
+   * --------------------
+   * Returns the year of the movie at the specified record, read from the byte
+   * that follows its title, without building a film or fetching its cast.
+   */
+
+  int getMovieYear(int movieRecord) const;
+
+  /**
+   * Methods: getNumActors
+   *          getNumMovies
+   *          getActorRecordAt
+   *          getMovieRecordAt
+   * -------------------------
+   * Enumerate every record in the actor or movie file, in sorted order
+   * (by name, or by title and then year).
+   *
+   * @param index a number in the range [0, getNumActors()) or [0, getNumMovies()).
+   * @return the offset of the index'th record.
+   */
+
+  int getNumActors() const;
+  int getNumMovies() const;
+  int getActorRecordAt(int index) const;
+  int getMovieRecordAt(int index) const;
+
+  /**
+   * Method: getDataStamp
+   * --------------------
+   * Returns the stamp (see data-format.h) of the data files this imdb opened,
+   * which the tools that build sidecars record in them.  Meaningless unless
+   * good() returns true.
+   */
+
+  const dataStamp& getDataStamp() const { return stamp; }
+
+  /**
+   * Method: getGraph
+   * ----------------
+   * Returns the compressed-sparse-row snapshot of the actor/movie graph
+   * (see imdb-graph.h) that was loaded alongside the data files, or NULL
+   * if there was none.
+   */
+
+  const imdbGraph *getGraph() const { return graph.good() ? &graph : NULL; }
+
+  /**
+   * Method: getCostarGraph
+   * ----------------------
+   * Returns the co-star adjacency (see costar-graph.h) loaded alongside the
+   * graph snapshot, or NULL if there was none.  Its IDs are those of getGraph(),
+   * so it's only ever loaded along with the snapshot.
+   */
+
+  const costarGraph *getCostarGraph() const { return costars.good() ? &costars : NULL; }
+
+  /**
+   * Method: getDistanceOracle
+   * -------------------------
+   * Returns the landmark labelling (see distance-oracle.h) built by build-labels
+   * and loaded alongside the graph snapshot, or NULL if there was none.  Like
+   * the co-star adjacency, it's keyed by the IDs of getGraph().
+   */
+
+  const distanceOracle *getDistanceOracle() const { return labels.good() ? &labels : NULL; }
+
+  /**
+   * Method: getSuggestIndex
+   * -----------------------
+   * Returns the actor name suggestion index (see suggest-index.h) built by
+   * build-index and loaded alongside the data files, or NULL if there was none.
+   */
+
+  const suggestIndex *getSuggestIndex() const { return suggestions.good() ? &suggestions : NULL; }
+
+  /**
+   * Method: setLookupMethod
+   * -----------------------
+   * Selects how names and films are found in the data files:
+   *
+   *     INDEXED             through the name index sidecars, if they were loaded,
+   *                         and by BSEARCH otherwise (the default)
+   *     BSEARCH             by binary search, comparing keys in place against the
+   *                         mapped records
+   *     REFERENCE_BSEARCH   by binary search, decoding each probed record into a
+   *                         film or name first (the original, slow comparators,
+   *                         kept so benchmarks have a baseline)
+   *
+   * @return false if INDEXED was requested but no name index was loaded.
+   */
+
+  static const int INDEXED = 1;
+  static const int BSEARCH = 2;
+  static const int REFERENCE_BSEARCH = 3;
+  bool setLookupMethod(int method);
+
+  /**
+   * Method: getMapOptions
+   * ---------------------
+   * Returns those of the mapOptions passed to the constructor that were
+   * applied successfully to both data files.
+   */
+
+  int getMapOptions() const { return mapOptions; }
+
+  /**
+   * Method: getFileSize
+   * -------------------
+   * Returns the size in bytes of the actor file (type == ACTOR) or the
+   * movie file (type == MOVIE), which bounds every record offset in it.
+   */
+
+  size_t getFileSize(int type) const;
 
   /**
    * Destructor: ~imdb
    * -----------------
    * Releases any resources associated with the imdb.
-   * Self-explantory.
+   * Self-explantory.  (Virtual, since cached_imdb extends imdb.)
    */
 
-  ~imdb();
+  virtual ~imdb();
   
  private:
 
   static const char *const kActorFileName;
   static const char *const kMovieFileName;
+  static const char *const kActorIndexFileName;
+  static const char *const kMovieIndexFileName;
+  static const char *const kGraphFileName;
+  static const char *const kCostarFileName;
+  static const char *const kLabelFileName;
+  static const char *const kStampFileName;
+  static const char *const kSuggestFileName;
   const void *actorFile;
   const void *movieFile;
+  nameIndex actorIndex;
+  nameIndex movieIndex;
+  suggestIndex suggestions;
+  imdbGraph graph;
+  costarGraph costars;
+  distanceOracle labels;
+  int lookupMethod;
+  int mapOptions;
+  int loadError;
+  string loadErrorMessage;
+  dataStamp stamp;
   
   /**
    * Method: searchFile
@@ -105,11 +388,14 @@ class imdb {
   // you're free to investigate, but you're on your own.
   struct fileInfo {
     int fd;
-    size_t fileSize;
-    const void *fileMap;
+    size_t fileSize;      // the size of the records, past any header
+    const void *fileMap;  // the start of the records
+    size_t mapSize;       // the size of the whole mapping
+    const void *mapBase;
   } actorInfo, movieInfo;
   
-  static const void *acquireFileMap(const string& fileName, struct fileInfo& info);
+  static int acquireFileMap(const string& fileName, struct fileInfo& info, int& options, int type);
+  bool validateFiles(const string& stampFileName);
   static void releaseFileMap(struct fileInfo& info);
 
   // marked as private so imdbs can't be copy constructed or reassigned.
@@ -0,0 +1,160 @@
+#ifndef __lru_cache__
+#define __lru_cache__
+
+#include <list>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <unordered_map>
+#include <algorithm>
+using namespace std;
+
+/**
+ * Convenience struct: cacheStats
+ * ------------------------------
+ * A snapshot of an lruCache's counters, summed over all of its shards.
+ */
+
+struct cacheStats {
+  long hits;
+  long misses;
+  long evictions;
+  size_t entries;
+  size_t bytesUsed;
+
+  cacheStats() : hits(0), misses(0), evictions(0), entries(0), bytesUsed(0) {}
+};
+
+/**
+ * Class: lruCache
+ * ---------------
+ * A bounded, thread-safe map from keys to immutable values.  The keys are
+ * spread over a number of shards by hash, and each shard has its own lock,
+ * its own share of the memory budget, and its own least-recently-used list,
+ * so threads looking up different keys rarely wait on one another.  Values
+ * are handed out as shared_ptrs to const, so a value evicted while a client
+ * is still reading it stays alive until the client lets go.
+ *
+ * The cache doesn't know how big a value is; the client says how many
+ * bytes each entry should be charged when inserting it.
+ */
+
+template <typename Key, typename Value, typename Hash = hash<Key> >
+class lruCache {
+ public:
+
+  /**
+   * Constructor: lruCache
+   * ---------------------
+   * @param memoryBudget the total number of bytes the entries may be charged.
+   * @param numShards the number of independently locked shards (raised to
+   *                  one if it's any less).
+   */
+
+  lruCache(size_t memoryBudget, int numShards) : shards(max(numShards, 1)) {
+    for (size_t i = 0; i < shards.size(); i++) shards[i].reset(new shard(memoryBudget / shards.size()));
+  }
+
+  /**
+   * Method: lookup
+   * --------------
+   * Returns the value cached under the specified key (marking it most
+   * recently used), or a null pointer if there isn't one.
+   */
+
+  shared_ptr<const Value> lookup(const Key& key) {
+    shard& s = shardFor(key);
+    lock_guard<mutex> guard(s.lock);
+    typename indexMap::iterator found = s.index.find(key);
+    if (found == s.index.end()) {
+      s.misses++;
+      return shared_ptr<const Value>();
+    }
+    s.hits++;
+    s.entries.splice(s.entries.begin(), s.entries, found->second);
+    return found->second->value;
+  }
+
+  /**
+   * Method: insert
+   * --------------
+   * Caches the specified value under the specified key, evicting least
+   * recently used entries from the key's shard until it fits.  Values
+   * bigger than a whole shard's budget aren't cached at all.
+   *
+   * @param bytes the number of bytes this entry counts against the budget.
+   */
+
+  void insert(const Key& key, const shared_ptr<const Value>& value, size_t bytes) {
+    shard& s = shardFor(key);
+    if (bytes > s.budget) return;
+    lock_guard<mutex> guard(s.lock);
+    if (s.index.find(key) != s.index.end()) return; // another thread beat us to it
+    while (s.bytesUsed + bytes > s.budget) {
+      const entry& victim = s.entries.back();
+      s.bytesUsed -= victim.bytes;
+      s.index.erase(victim.key);
+      s.entries.pop_back();
+      s.evictions++;
+    }
+    s.entries.push_front(entry(key, value, bytes));
+    s.index[key] = s.entries.begin();
+    s.bytesUsed += bytes;
+  }
+
+  /**
+   * Method: getStats
+   * ----------------
+   * Returns the counters summed over every shard.
+   */
+
+  cacheStats getStats() const {
+    cacheStats total;
+    for (size_t i = 0; i < shards.size(); i++) {
+      lock_guard<mutex> guard(shards[i]->lock);
+      total.hits += shards[i]->hits;
+      total.misses += shards[i]->misses;
+      total.evictions += shards[i]->evictions;
+      total.entries += shards[i]->index.size();
+      total.bytesUsed += shards[i]->bytesUsed;
+    }
+    return total;
+  }
+
+ private:
+  struct entry {
+    Key key;
+    shared_ptr<const Value> value;
+    size_t bytes;
+
+    entry(const Key& key, const shared_ptr<const Value>& value, size_t bytes) :
+      key(key), value(value), bytes(bytes) {}
+  };
+
+  typedef unordered_map<Key, typename list<entry>::iterator, Hash> indexMap;
+
+  struct shard {
+    mutable mutex lock;
+    list<entry> entries; // most recently used first
+    indexMap index;
+    size_t budget;
+    size_t bytesUsed;
+    long hits, misses, evictions;
+
+    shard(size_t budget) : budget(budget), bytesUsed(0), hits(0), misses(0), evictions(0) {}
+  };
+
+  shard& shardFor(const Key& key) {
+    // the low bits feed the shard's own hash table, so pick shards with the high ones
+    size_t h = Hash()(key);
+    return *shards[(h >> 16) % shards.size()];
+  }
+
+  vector<unique_ptr<shard> > shards;
+
+  lruCache(const lruCache& original);
+  lruCache& operator=(const lruCache& rhs);
+};
+
+#endif
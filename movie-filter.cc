@@ -0,0 +1,81 @@
+#include "movie-filter.h"
+#include <climits>
+#include <cstdlib>
+using namespace std;
+
+static const int kYearsPerDecade = 10;
+
+yearIndex::yearIndex(const imdb& db) : db(db), firstDecade(0)
+{
+  int numMovies = db.getNumMovies();
+  vector<int> years(numMovies);
+  int lastDecade = 0;
+  for (int i = 0; i < numMovies; i++) {
+    years[i] = db.getMovieYear(db.getMovieRecordAt(i));
+    int d = years[i] / kYearsPerDecade;
+    if (i == 0 || d < firstDecade) firstDecade = d;
+    if (i == 0 || d > lastDecade) lastDecade = d;
+  }
+  if (numMovies == 0) return;
+
+  decades.resize(lastDecade - firstDecade + 1);
+  for (int i = 0; i < numMovies; i++) {
+    decade& d = decades[years[i] / kYearsPerDecade - firstDecade];
+    if (!d.movies) d.movies.reset(new recordSet(db.getFileSize(imdb::MOVIE)));
+    int record = db.getMovieRecordAt(i);
+    d.movies->insert(record);
+    d.records.push_back(record);
+  }
+}
+
+void yearIndex::select(int firstYear, int lastYear, recordSet& movies) const
+{
+  for (size_t i = 0; i < decades.size(); i++) {
+    const decade& d = decades[i];
+    if (!d.movies) continue;
+    int decadeStart = (firstDecade + (int) i) * kYearsPerDecade;
+    int decadeEnd = decadeStart + kYearsPerDecade - 1;
+    if (decadeEnd < firstYear || decadeStart > lastYear) continue;
+    if (decadeStart >= firstYear && decadeEnd <= lastYear) {
+      movies.unite(*d.movies);
+    } else {
+      for (size_t j = 0; j < d.records.size(); j++) {
+	int year = db.getMovieYear(d.records[j]);
+	if (year >= firstYear && year <= lastYear) movies.insert(d.records[j]);
+      }
+    }
+  }
+}
+
+movieFilter::movieFilter(const imdb& db, int firstYear, int lastYear) :
+  db(db), firstYear(firstYear), lastYear(lastYear) {}
+
+movieFilter::movieFilter(const yearIndex& index, int firstYear, int lastYear) :
+  db(index.getDatabase()), firstYear(firstYear), lastYear(lastYear),
+  movies(new recordSet(db.getFileSize(imdb::MOVIE)))
+{
+  index.select(firstYear, lastYear, *movies);
+}
+
+movieFilter::movieFilter(const imdb& db, const function<bool(int)>& predicate) :
+  db(db), firstYear(INT_MIN), lastYear(INT_MAX), predicate(predicate) {}
+
+bool parseYearRange(const string& text, int& firstYear, int& lastYear)
+{
+  size_t dash = text.find('-');
+  string first = text.substr(0, dash);
+  string last = dash == string::npos ? first : text.substr(dash + 1);
+  if (first.empty() && last.empty()) return false;
+  char *end;
+  firstYear = INT_MIN;
+  lastYear = INT_MAX;
+  if (!first.empty()) {
+    firstYear = strtol(first.c_str(), &end, 10);
+    if (*end != '\0') return false;
+  }
+  if (!last.empty()) {
+    lastYear = strtol(last.c_str(), &end, 10);
+    if (*end != '\0') return false;
+  }
+  return firstYear <= lastYear;
+}
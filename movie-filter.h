@@ -0,0 +1,113 @@
+#ifndef __movie_filter__
+#define __movie_filter__
+
+#include "imdb.h"
+#include "record-set.h"
+#include <vector>
+#include <memory>
+#include <functional>
+using namespace std;
+
+/**
+ * Class: yearIndex
+ * ----------------
+ * An in-memory index of an imdb's movies by decade: for every decade that
+ * has any movies, a recordSet of those movies and a list of their records.
+ * It's built with one pass over the movie file, and afterwards selecting
+ * every movie in a range of years costs a word-by-word union for each
+ * decade the range covers completely, plus a walk over the movies of the
+ * (at most two) decades it only partly covers.
+ */
+
+class yearIndex {
+ public:
+
+  /**
+   * Constructor: yearIndex
+   * ----------------------
+   * Indexes every movie of the specified imdb, which must outlive the index.
+   */
+
+  yearIndex(const imdb& db);
+
+  /**
+   * Method: select
+   * --------------
+   * Adds every movie made in the years [firstYear, lastYear] to movies,
+   * a set sized for the movie file (see imdb::getFileSize).
+   */
+
+  void select(int firstYear, int lastYear, recordSet& movies) const;
+
+  const imdb& getDatabase() const { return db; }
+
+ private:
+  struct decade {
+    unique_ptr<recordSet> movies;
+    vector<int> records;
+  };
+
+  const imdb& db;
+  int firstDecade;
+  vector<decade> decades;
+
+  yearIndex(const yearIndex& original);
+  yearIndex& operator=(const yearIndex& rhs);
+};
+
+/**
+ * Class: movieFilter
+ * ------------------
+ * Decides which movies a filtered search (see getShortestPathFiltered) may
+ * pass through.  A filter is one of
+ *
+ *     a year range      checked against the year stored inline in each movie
+ *                       record, with no cast or film built
+ *     an indexed range  precomputed from a yearIndex into one recordSet, so
+ *                       each check is a single bit test
+ *     a predicate       any function of the movie's record offset
+ *
+ * Filters are built per query and are read-only afterwards, so one filter
+ * may be shared by any number of concurrent searches.
+ */
+
+class movieFilter {
+ public:
+  movieFilter(const imdb& db, int firstYear, int lastYear);
+  movieFilter(const yearIndex& index, int firstYear, int lastYear);
+  movieFilter(const imdb& db, const function<bool(int)>& predicate);
+
+  /**
+   * Method: allows
+   * --------------
+   * Returns true if and only if the movie at the specified record
+   * passes the filter.
+   */
+
+  bool allows(int movieRecord) const {
+    if (movies) return movies->contains(movieRecord);
+    if (predicate) return predicate(movieRecord);
+    int year = db.getMovieYear(movieRecord);
+    return year >= firstYear && year <= lastYear;
+  }
+
+ private:
+  const imdb& db;
+  int firstYear;
+  int lastYear;
+  unique_ptr<recordSet> movies;
+  function<bool(int)> predicate;
+};
+
+/**
+ * Function: parseYearRange
+ * ------------------------
+ * Parses a range of years written "1930-1969", "-1969", "1930-", or "1955"
+ * (a single year).  An open end is left at INT_MIN or INT_MAX.
+ *
+ * @return true if and only if the text was a well-formed range.
+ */
+
+bool parseYearRange(const string& text, int& firstYear, int& lastYear);
+
+#endif
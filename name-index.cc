@@ -0,0 +1,163 @@
+using namespace std;
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include "name-index.h"
+
+nameIndex::nameIndex() :
+  fileMap(NULL), fileSize(0), numKeys(0), numBuckets(0), displacements(NULL), slots(NULL) {}
+
+/**
+ * A sidecar is only trusted if its header matches and its size is exactly
+ * what the header says it should be; anything else is left unloaded so
+ * the imdb falls back on bsearch.
+ */
+
+bool nameIndex::load(const string& fileName, size_t dataFileSize, const dataStamp& stamp)
+{
+  int fd = open(fileName.c_str(), O_RDONLY);
+  if (fd == -1) return false;
+  struct stat stats;
+  if (fstat(fd, &stats) == -1 || stats.st_size < (off_t) (kHeaderInts * sizeof(int))) {
+    close(fd);
+    return false;
+  }
+  void *map = mmap(0, stats.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) return false;
+
+  const int *header = (const int *) map;
+  size_t expectedSize = (kHeaderInts + (size_t) header[3] + header[4]) * sizeof(int);
+  if (header[0] != kMagic || header[1] != kVersion || header[2] != (int) dataFileSize ||
+      header[3] <= 0 || header[4] <= 0 || expectedSize != (size_t) stats.st_size ||
+      !stamp.matches(header + kStampAt)) {
+    munmap(map, stats.st_size);
+    return false;
+  }
+
+  fileMap = map;
+  fileSize = stats.st_size;
+  numKeys = header[3];
+  numBuckets = header[4];
+  displacements = header + kHeaderInts;
+  slots = displacements + numBuckets;
+  return true;
+}
+
+/**
+ * Finalizer borrowed from splitmix64; it spreads every input bit
+ * over the whole of the output.
+ */
+
+static uint64_t mix(uint64_t h)
+{
+  h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+  return h ^ (h >> 31);
+}
+
+/**
+ * 64-bit FNV-1a over the specified bytes, continuing from the specified hash.
+ */
+
+static uint64_t fnv(const char *bytes, size_t length, uint64_t h = 0xcbf29ce484222325ULL)
+{
+  for (size_t i = 0; i < length; i++) {
+    h ^= (unsigned char) bytes[i];
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+uint64_t nameIndex::hashActor(const char *name)
+{
+  return mix(fnv(name, strlen(name)));
+}
+
+uint64_t nameIndex::hashMovie(const char *title, int year)
+{
+  char yearByte = (char) (year - 1900);
+  return mix(fnv(&yearByte, 1, fnv(title, strlen(title) + 1)));
+}
+
+size_t nameIndex::slotFor(uint64_t hash, int displacement, int numKeys)
+{
+  if (displacement < 0) return -(displacement + 1);
+  return mix(hash + displacement * 0x9e3779b97f4a7c15ULL) % numKeys;
+}
+
+int nameIndex::lookup(uint64_t hash) const
+{
+  int displacement = displacements[(hash >> 32) % numBuckets];
+  return slots[slotFor(hash, displacement, numKeys)];
+}
+
+/**
+ * Buckets are placed largest first, while the table is still mostly empty,
+ * by trying displacements until every key in the bucket lands on a free
+ * slot.  By the time the single-key buckets come up, the free slots can just
+ * be handed out in order.
+ */
+
+bool nameIndex::write(const string& fileName, const vector<uint64_t>& hashes,
+		      const vector<int>& records, size_t dataFileSize, const dataStamp& stamp)
+{
+  const int kMaxDisplacement = 1 << 24;
+  int keys = hashes.size();
+  if (keys == 0) return false;
+  int buckets = keys / kKeysPerBucket + 1;
+
+  vector<vector<int> > members(buckets);
+  for (int i = 0; i < keys; i++)
+    members[(hashes[i] >> 32) % buckets].push_back(i);
+  vector<pair<int, int> > order; // (size, bucket)
+  for (int b = 0; b < buckets; b++) order.push_back(make_pair((int) members[b].size(), b));
+  sort(order.rbegin(), order.rend());
+
+  vector<int> displacement(buckets, 0);
+  vector<int> slot(keys, -1);
+  vector<size_t> trial;
+  size_t nextFree = 0;
+  for (int i = 0; i < buckets && order[i].first > 0; i++) {
+    const vector<int>& bucket = members[order[i].second];
+    if (bucket.size() == 1) {
+      while (slot[nextFree] != -1) nextFree++;
+      slot[nextFree] = records[bucket[0]];
+      displacement[order[i].second] = -(int) (nextFree + 1);
+      continue;
+    }
+
+    int d;
+    for (d = 0; d < kMaxDisplacement; d++) {
+      trial.clear();
+      for (size_t k = 0; k < bucket.size(); k++) {
+	size_t s = slotFor(hashes[bucket[k]], d, keys);
+	if (slot[s] != -1 || find(trial.begin(), trial.end(), s) != trial.end()) break;
+	trial.push_back(s);
+      }
+      if (trial.size() == bucket.size()) break;
+    }
+    if (d == kMaxDisplacement) return false; // only duplicate keys get here
+    for (size_t k = 0; k < bucket.size(); k++) slot[trial[k]] = records[bucket[k]];
+    displacement[order[i].second] = d;
+  }
+
+  FILE *out = fopen(fileName.c_str(), "wb");
+  if (out == NULL) return false;
+  int header[kHeaderInts] = { kMagic, kVersion, (int) dataFileSize, keys, buckets };
+  stamp.store(header + kStampAt);
+  bool ok = fwrite(header, sizeof(int), kHeaderInts, out) == (size_t) kHeaderInts &&
+    fwrite(&displacement[0], sizeof(int), buckets, out) == (size_t) buckets &&
+    fwrite(&slot[0], sizeof(int), keys, out) == (size_t) keys;
+  return fclose(out) == 0 && ok;
+}
+
+nameIndex::~nameIndex()
+{
+  if (fileMap != NULL) munmap((char *) fileMap, fileSize);
+}
@@ -0,0 +1,132 @@
+#ifndef __name_index__
+#define __name_index__
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "data-format.h"
+using namespace std;
+
+/**
+ * Class: nameIndex
+ * ----------------
+ * A minimal perfect hash over the names (or titles and years) stored in one
+ * imdb data file, kept in a sidecar file next to it.  Every key in the data
+ * file hashes to its own slot, and the slot holds the offset of that key's
+ * record, so a lookup costs one hash and one probe into the data file to
+ * confirm the match, instead of the twenty-odd probes bsearch makes.
+ *
+ * Keys are distributed over buckets, and each bucket stores a displacement
+ * chosen offline so that its keys land in distinct slots (a bucket holding
+ * a single key instead stores its slot directly, as -(slot + 1)).
+ *
+ * The sidecar layout, all native-endian 32-bit ints, is:
+ *
+ *     magic, version, data file size, number of keys, number of buckets,
+ *     data stamp[dataStamp::kInts],
+ *     displacements[number of buckets], record offsets[number of keys]
+ *
+ * The data file size and the stamp of the data files (see data-format.h) are
+ * recorded so a stale sidecar is never trusted.
+ */
+
+class nameIndex {
+ public:
+
+  /**
+   * Constructor: nameIndex
+   * ----------------------
+   * Constructs an index with nothing loaded; good() returns false
+   * until load succeeds.
+   */
+
+  nameIndex();
+
+  /**
+   * Method: load
+   * ------------
+   * Maps the named sidecar file into memory, provided it exists, is well formed,
+   * and was built against a data file of the specified size, from data files
+   * with the specified stamp.
+   *
+   * @return true if and only if the index is now ready for lookups.
+   */
+
+  bool load(const string& fileName, size_t dataFileSize, const dataStamp& stamp);
+
+  /**
+   * Predicate Method: good
+   * ----------------------
+   * Returns true if and only if an index has been successfully loaded.
+   */
+
+  bool good() const { return slots != NULL; }
+
+  /**
+   * Method: lookup
+   * --------------
+   * Returns the record offset stored in the slot the specified hash maps to.
+   * Keys not in the data file map to an arbitrary slot too, so the caller must
+   * confirm that the record found really matches the key.
+   */
+
+  int lookup(uint64_t hash) const;
+
+  /**
+   * Methods: hashActor
+   *          hashMovie
+   * ------------------
+   * Hash an actor's name, or a movie's title and year, exactly as
+   * the keys stored in the index were hashed.
+   */
+
+  static uint64_t hashActor(const char *name);
+  static uint64_t hashMovie(const char *title, int year);
+
+  /**
+   * Method: write
+   * -------------
+   * Builds a minimal perfect hash over the specified key hashes and writes it,
+   * along with the record offset belonging to each key, to the named file.
+   *
+   * @param fileName the sidecar file being written.
+   * @param hashes the hash of each key in the data file.
+   * @param records the record offset of each key, parallel to hashes.
+   * @param dataFileSize the size of the data file the keys came from.
+   * @param stamp the stamp of the data files the keys came from.
+   * @return true if and only if the file was written successfully.
+   */
+
+  static bool write(const string& fileName, const vector<uint64_t>& hashes,
+		    const vector<int>& records, size_t dataFileSize, const dataStamp& stamp);
+
+  /**
+   * Destructor: ~nameIndex
+   * ----------------------
+   * Unmaps the sidecar file, if one was loaded.
+   */
+
+  ~nameIndex();
+
+ private:
+  static const int kMagic = 0x78646e69; // "indx"
+  static const int kVersion = 2;
+  static const int kStampAt = 5;
+  static const int kHeaderInts = kStampAt + dataStamp::kInts;
+  static const int kKeysPerBucket = 4;
+
+  static size_t slotFor(uint64_t hash, int displacement, int numKeys);
+
+  const void *fileMap;
+  size_t fileSize;
+  int numKeys;
+  int numBuckets;
+  const int *displacements;
+  const int *slots;
+
+  // not copyable, for the same reasons an imdb isn't
+  nameIndex(const nameIndex& original);
+  nameIndex& operator=(const nameIndex& rhs);
+};
+
+#endif
@@ -0,0 +1,276 @@
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "imdb.h"
+#include "path.h"
+#include "shortest-path.h"
+#include "worker-pool.h"
+#include "alloc-count.h"
+#include "query-profile.h"
+using namespace std;
+
+/**
+ * The actor pairs searched when no pairs file is supplied.  They
+ * are chosen to span short, medium, and long paths in the full
+ * dataset, so that the benchmark exercises both cheap and expensive
+ * searches.  Pairs naming people missing from the database are skipped.
+ */
+
+static const char *const kDefaultPairs[][2] = {
+  { "Kevin Bacon", "Tom Hanks" },
+  { "Kevin Bacon", "Meryl Streep" },
+  { "Julia Roberts", "Hugh Grant" },
+  { "Emma Stone", "Sam Neill" },
+  { "Anna Faris", "Bob Hope" },
+  { "Cara Delevingne", "Dan Aykroyd" },
+  { "Willie Best", "Fay Wray" },
+  { "Jennifer Tilly", "Hal Holbrook" },
+  { "Jon Voight", "Kim Novak" },
+  { "Lou Reed", "Mary Pickford" }
+};
+
+/**
+ * Function: readPairs
+ * -------------------
+ * Populates pairs with the actor pairs listed in the named file,
+ * one pair per line with the two names separated by a tab.  If
+ * fileName is NULL, the built-in kDefaultPairs are used instead.
+ *
+ * @return false if and only if the named file couldn't be opened.
+ */
+
+static bool readPairs(const char *fileName, vector<pair<string, string> >& pairs)
+{
+  if (fileName == NULL) {
+    for (size_t i = 0; i < sizeof(kDefaultPairs) / sizeof(kDefaultPairs[0]); i++)
+      pairs.push_back(make_pair(string(kDefaultPairs[i][0]), string(kDefaultPairs[i][1])));
+    return true;
+  }
+
+  return readActorPairs(fileName, pairs);
+}
+
+/**
+ * Function: runScaling
+ * --------------------
+ * Runs the parallel engine over every pair with pools of 1, 2, 4, 8, and 16
+ * workers, reporting the total time taken at each size and the speedup over
+ * a single worker.
+ *
+ * @return the number of pairs for which some pool size found a path whose
+ *         length differed from the one the single worker found.
+ */
+
+static int runScaling(const imdb& db, const vector<pair<string, string> >& pairs)
+{
+  const int kThreadCounts[] = { 1, 2, 4, 8, 16 };
+  const int kNumThreadCounts = sizeof(kThreadCounts) / sizeof(kThreadCounts[0]);
+  vector<int> lengths;
+  double baseline = 0;
+  int mismatches = 0;
+  cout << setw(8) << "threads" << setw(12) << "ms" << setw(10) << "speedup" << endl;
+  for (int t = 0; t < kNumThreadCounts; t++) {
+    workerPool pool(kThreadCounts[t]);
+    double start = monotonicSeconds();
+    for (size_t i = 0; i < pairs.size(); i++) {
+      int length = getShortestPathParallel(pairs[i].first, pairs[i].second, db, pool).getLength();
+      if (t == 0) lengths.push_back(length);
+      else if (length != lengths[i]) mismatches++;
+    }
+    double elapsed = monotonicSeconds() - start;
+    if (t == 0) baseline = elapsed;
+    cout << setw(8) << kThreadCounts[t] << setw(12) << elapsed * 1000
+	 << setw(9) << baseline / elapsed << "x" << endl;
+  }
+  return mismatches;
+}
+
+/**
+ * Function: runStartup
+ * --------------------
+ * Measures time to first query under each way of mapping the data files
+ * (see imdb's constructor): how long constructing the imdb takes, how long
+ * the first search (by the "records" engine) takes after that, and how many
+ * page faults that first search incurs.  With cold set, the data files are
+ * evicted from the page cache before each mode, as after a fresh deploy.
+ *
+ * @return false, after explaining why on cerr, if the data couldn't be loaded.
+ */
+
+static bool runStartup(const string& directory, const pair<string, string>& query, bool cold)
+{
+  const int kModes[] = { 0, imdb::PREFAULT, imdb::PREFAULT | imdb::HUGE_PAGES, imdb::LOCK_PAGES };
+  const char *kModeNames[] = { "lazy", "prefault", "prefault+huge", "lock" };
+  cout << left << setw(16) << "mapping" << right << setw(12) << "open-ms" << setw(12) << "query-ms"
+       << setw(12) << "total-ms" << setw(10) << "faults" << "  applied" << endl;
+  for (int m = 0; m < 4; m++) {
+    if (cold) {
+      evictFile(directory + "/actordata");
+      evictFile(directory + "/moviedata");
+    }
+    double start = monotonicSeconds();
+    imdb db(directory, kModes[m]);
+    double opened = monotonicSeconds();
+    if (!db.good()) {
+      cerr << db.getLoadErrorMessage() << "  Aborting..." << endl;
+      return false;
+    }
+    struct rusage before, after;
+    getrusage(RUSAGE_SELF, &before);
+    getShortestPathByRecord(query.first, query.second, db);
+    getrusage(RUSAGE_SELF, &after);
+    double answered = monotonicSeconds();
+    long faults = (after.ru_minflt - before.ru_minflt) + (after.ru_majflt - before.ru_majflt);
+    int applied = db.getMapOptions();
+    cout << left << setw(16) << kModeNames[m] << right << setw(12) << (opened - start) * 1000
+	 << setw(12) << (answered - opened) * 1000 << setw(12) << (answered - start) * 1000
+	 << setw(10) << faults << "  "
+	 << (applied & imdb::PREFAULT ? "prefault " : "") << (applied & imdb::HUGE_PAGES ? "huge " : "")
+	 << (applied & imdb::LOCK_PAGES ? "lock" : "") << endl;
+  }
+  return true;
+}
+
+/**
+ * Function: runProfile
+ * --------------------
+ * Runs every engine over every pair once more with profiling switched on
+ * (see query-profile.h), and prints each engine's aggregate profile as a
+ * line of JSON.  The timed runs above are made with profiling off.
+ */
+
+static void runProfile(const imdb& db, const vector<pair<string, string> >& pairs)
+{
+  if (!setProfiling(true)) {
+    cerr << "Profiling isn't compiled in; rebuild with make clean; make PROFILE=1." << endl;
+    return;
+  }
+  for (int e = 0; e < kNumSearchEngines; e++) {
+    resetAggregateProfile();
+    for (size_t i = 0; i < pairs.size(); i++) {
+      beginQueryProfile();
+      kSearchEngines[e].search(pairs[i].first, pairs[i].second, db, NULL);
+      endQueryProfile();
+    }
+    cout << "{\"engine\": " << jsonQuote(kSearchEngines[e].name)
+	 << ", \"profile\": " << aggregateProfileAsJson() << "}" << endl;
+  }
+  setProfiling(false);
+}
+
+/**
+ * Function: main
+ * --------------
+ * Runs every search engine listed in kSearchEngines over the same fixed
+ * set of actor pairs, reporting the path length found, how many actors
+ * each engine expanded, and how long each took.  The totals are followed by
+ * the average number of heap allocations each engine made per query (see
+ * alloc-count.h).  The exit status is nonzero if any engine ever disagrees
+ * with the first on length.
+ *
+ * With --scaling, the parallel engine is timed at several pool sizes
+ * instead (see runScaling).  With --startup (or --startup-cold), time to
+ * first query is measured under each way of mapping the data files, using
+ * the first pair (see runStartup).  With --profile, each engine's aggregate
+ * profile follows the totals (see runProfile).
+ *
+ * Usage: path-bench [--scaling | --startup | --startup-cold | --profile] [data-directory [pairs-file]]
+ */
+
+int main(int argc, const char *argv[])
+{
+  bool scaling = false, startup = false, cold = false, profile = false;
+  vector<const char *> positional;
+  for (int i = 1; i < argc; i++) {
+    if (string(argv[i]) == "--scaling") scaling = true;
+    else if (string(argv[i]) == "--startup") startup = true;
+    else if (string(argv[i]) == "--startup-cold") startup = cold = true;
+    else if (string(argv[i]) == "--profile") profile = true;
+    else positional.push_back(argv[i]);
+  }
+
+  vector<pair<string, string> > pairs;
+  if (!readPairs(positional.size() > 1 ? positional[1] : NULL, pairs)) {
+    cerr << "Couldn't open \"" << positional[1] << "\".  Aborting..." << endl;
+    return 1;
+  }
+
+  string directory = determinePathToData(positional.size() > 0 ? positional[0] : NULL);
+  cout << fixed << setprecision(2);
+  if (startup) {
+    if (pairs.empty()) {
+      cerr << "--startup needs at least one pair to query.  Aborting..." << endl;
+      return 1;
+    }
+    return runStartup(directory, pairs[0], cold) ? 0 : 1;
+  }
+
+  imdb db(directory);
+  if (!db.good()) { cerr << db.getLoadErrorMessage() << "  Aborting..." << endl; return 1; }
+  if (scaling) {
+    int mismatches = runScaling(db, pairs);
+    if (mismatches == 0) return 0;
+    cerr << mismatches << " search(es) produced paths of different lengths." << endl;
+    return 1;
+  }
+
+  cout << left << setw(50) << "pair" << right << setw(6) << "len";
+  for (int e = 0; e < kNumSearchEngines; e++)
+    cout << setw(16) << (string(kSearchEngines[e].name) + "-nodes")
+	 << setw(16) << (string(kSearchEngines[e].name) + "-ms");
+  cout << endl;
+
+  vector<searchStats> totals(kNumSearchEngines);
+  vector<double> times(kNumSearchEngines, 0);
+  vector<long> allocations(kNumSearchEngines, 0);
+  int queries = 0, mismatches = 0;
+  for (size_t i = 0; i < pairs.size(); i++) {
+    const string& source = pairs[i].first;
+    const string& target = pairs[i].second;
+    vector<film> credits;
+    if (!db.getCredits(source, credits) || !db.getCredits(target, credits)) continue;
+
+    vector<searchStats> stats(kNumSearchEngines);
+    vector<double> elapsed(kNumSearchEngines);
+    vector<int> lengths(kNumSearchEngines);
+    queries++;
+    for (int e = 0; e < kNumSearchEngines; e++) {
+      long allocationsBefore = getAllocationCount();
+      double start = monotonicSeconds();
+      lengths[e] = kSearchEngines[e].search(source, target, db, &stats[e]).getLength();
+      elapsed[e] = monotonicSeconds() - start;
+      allocations[e] += getAllocationCount() - allocationsBefore;
+      totals[e].actorsExpanded += stats[e].actorsExpanded;
+      times[e] += elapsed[e];
+    }
+
+    cout << left << setw(50) << (source + " / " + target) << right << setw(6) << lengths[0];
+    for (int e = 0; e < kNumSearchEngines; e++)
+      cout << setw(16) << stats[e].actorsExpanded << setw(16) << elapsed[e] * 1000;
+    for (int e = 1; e < kNumSearchEngines; e++) {
+      if (lengths[e] == lengths[0]) continue;
+      cout << "  MISMATCH (" << kSearchEngines[e].name << " found " << lengths[e] << ")";
+      mismatches++;
+    }
+    cout << endl;
+  }
+
+  cout << left << setw(50) << "total" << right << setw(6) << "";
+  for (int e = 0; e < kNumSearchEngines; e++)
+    cout << setw(16) << totals[e].actorsExpanded << setw(16) << times[e] * 1000;
+  cout << endl;
+  cout << left << setw(50) << "allocations/query" << right << setw(6) << "";
+  for (int e = 0; e < kNumSearchEngines; e++)
+    cout << setw(32) << (queries == 0 ? 0.0 : (double) allocations[e] / queries);
+  cout << endl;
+  if (profile) runProfile(db, pairs);
+  if (mismatches > 0) {
+    cerr << mismatches << " search(es) produced paths of different lengths." << endl;
+    return 1;
+  }
+  return 0;
+}
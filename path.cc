@@ -49,6 +49,17 @@ const string& path::getLastPlayer() const
   return links.back().player;
 }
 
+const string& path::getPlayer(int i) const
+{
+  if (i == 0) return startPlayer;
+  return links[i - 1].player;
+}
+
+const film& path::getMovie(int i) const
+{
+  return links[i].movie;
+}
+
 void path::reverse()
 {
   // construct the reverse
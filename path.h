@@ -106,6 +106,22 @@ class path {
   
   const string& getLastPlayer() const;
 
+  /**
+   * Methods: getPlayer
+   *          getMovie
+   * ------------------
+   * Provide read access to the individual links of the path, for clients
+   * that want something other than operator<<'s formatting.  getPlayer(0) is
+   * the start player, and for i in [1, getLength()], getPlayer(i) is the player
+   * reached through movie getMovie(i - 1).
+   *
+   * @param i the index of the player or movie being requested.
+   * @return the address of the requested player's name or movie.
+   */
+
+  const string& getPlayer(int i) const;
+  const film& getMovie(int i) const;
+
   /**
    * Method: reverse
    * ---------------
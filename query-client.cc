@@ -0,0 +1,58 @@
+#include <string>
+#include <vector>
+#include <iostream>
+#include <unistd.h>
+#include "query-protocol.h"
+using namespace std;
+
+/**
+ * Serves as the main entry point for the query-client executable, which sends
+ * one query to a server started with six-degrees --serve and prints the reply.
+ *
+ * Usage: query-client [--socket=path] path <actor> <actor>
+ *        query-client [--socket=path] credits <actor>
+ *        query-client [--socket=path] cast <title> <year>
+ *        query-client [--socket=path] costars <actor>
+ *
+ * The rows of the reply are printed one per line, with their fields
+ * separated by tabs (see query-protocol.h).
+ *
+ * @return 0 if the server answered the query, and 1 otherwise.
+ */
+
+int main(int argc, char *argv[])
+{
+  string socketPath = kDefaultSocketPath;
+  string query;
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg.compare(0, 9, "--socket=") == 0) socketPath = arg.substr(9);
+    else query += (query.empty() ? "" : "\t") + arg;
+  }
+  if (query.empty()) {
+    cerr << "Usage: " << argv[0] << " [--socket=path] path|credits|cast|costars <arguments>" << endl;
+    return 1;
+  }
+
+  int fd = connectToServer(socketPath);
+  if (fd == -1) {
+    cerr << "Couldn't connect to a server on \"" << socketPath << "\"." << endl;
+    return 1;
+  }
+  string reply;
+  bool answered = sendFrame(fd, query) && receiveFrame(fd, reply);
+  close(fd);
+  if (!answered) {
+    cerr << "The server closed the connection." << endl;
+    return 1;
+  }
+
+  vector<string> rows;
+  splitFields(reply, '\n', rows);
+  if (rows[0] != "ok") {
+    cerr << rows[0].substr(rows[0].find('\t') + 1) << endl;
+    return 1;
+  }
+  for (size_t i = 1; i < rows.size(); i++) cout << rows[i] << endl;
+  return 0;
+}
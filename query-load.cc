@@ -0,0 +1,122 @@
+#include <string>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <algorithm>
+#include <cstdlib>
+#include <unistd.h>
+#include "imdb-utils.h"
+#include "query-protocol.h"
+using namespace std;
+
+/**
+ * Convenience struct: loadResult
+ * ------------------------------
+ * What one connection of the load generator saw: the latency of every
+ * query it completed, and how many replies were errors.
+ */
+
+struct loadResult {
+  vector<double> latencies;
+  long errors;
+  bool connected;
+
+  loadResult() : errors(0), connected(false) {}
+};
+
+/**
+ * Runs one closed-loop client: it sends a path query, waits for the reply,
+ * and sends the next, working through the pairs from a different starting
+ * point than the other clients, until the deadline passes.
+ */
+
+static void runClient(const string& socketPath, const vector<pair<string, string> >& pairs,
+		      size_t first, double deadline, loadResult& result)
+{
+  int fd = connectToServer(socketPath);
+  if (fd == -1) return;
+  result.connected = true;
+  string reply;
+  for (size_t i = first; monotonicSeconds() < deadline; i = (i + 1) % pairs.size()) {
+    double start = monotonicSeconds();
+    if (!sendFrame(fd, "path\t" + pairs[i].first + "\t" + pairs[i].second) ||
+	!receiveFrame(fd, reply)) {
+      result.errors++;
+      break;
+    }
+    result.latencies.push_back(monotonicSeconds() - start);
+    if (reply.compare(0, 2, "ok") != 0) result.errors++;
+  }
+  close(fd);
+}
+
+/**
+ * Serves as the main entry point for the query-load executable, which drives
+ * a server started with six-degrees --serve with path queries from several
+ * connections at once, and reports the sustained throughput and the latency
+ * distribution it saw.
+ *
+ * Usage: query-load [--socket=path] [--connections=N] [--seconds=S] pairs-file
+ *
+ * The pairs file lists one actor pair per line, the two names separated by
+ * a tab.  Each of the N connections (8 by default) keeps exactly one query
+ * outstanding for S seconds (10 by default).
+ *
+ * @return 0 if every connection was made, and 1 otherwise.
+ */
+
+int main(int argc, char *argv[])
+{
+  string socketPath = kDefaultSocketPath;
+  int numConnections = 8;
+  double seconds = 10;
+  const char *pairsFile = NULL;
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg.compare(0, 9, "--socket=") == 0) socketPath = arg.substr(9);
+    else if (arg.compare(0, 14, "--connections=") == 0) numConnections = max(1, atoi(argv[i] + 14));
+    else if (arg.compare(0, 10, "--seconds=") == 0) seconds = atof(argv[i] + 10);
+    else pairsFile = argv[i];
+  }
+
+  vector<pair<string, string> > pairs;
+  if (pairsFile == NULL || !readActorPairs(pairsFile, pairs) || pairs.empty()) {
+    cerr << "Usage: " << argv[0] << " [--socket=path] [--connections=N] [--seconds=S] pairs-file" << endl;
+    return 1;
+  }
+
+  vector<loadResult> results(numConnections);
+  vector<thread> clients;
+  double start = monotonicSeconds();
+  for (int i = 0; i < numConnections; i++)
+    clients.push_back(thread(runClient, socketPath, ref(pairs), i * pairs.size() / numConnections,
+			     start + seconds, ref(results[i])));
+  for (int i = 0; i < numConnections; i++) clients[i].join();
+  double elapsed = monotonicSeconds() - start;
+
+  vector<double> latencies;
+  long errors = 0;
+  int connected = 0;
+  for (int i = 0; i < numConnections; i++) {
+    latencies.insert(latencies.end(), results[i].latencies.begin(), results[i].latencies.end());
+    errors += results[i].errors;
+    if (results[i].connected) connected++;
+  }
+  if (connected < numConnections) {
+    cerr << "Only " << connected << " of " << numConnections << " connections to \""
+	 << socketPath << "\" succeeded." << endl;
+    if (connected == 0) return 1;
+  }
+
+  sort(latencies.begin(), latencies.end());
+  cout << latencies.size() << " queries on " << connected << " connections in " << elapsed << " s: "
+       << (long) (latencies.size() / elapsed) << " queries/sec, " << errors << " errors" << endl;
+  const double kPercentiles[] = { 50, 90, 99, 99.9, 100 };
+  const char *const kPercentileNames[] = { "p50", "p90", "p99", "p99.9", "max" };
+  for (size_t p = 0; p < sizeof(kPercentiles) / sizeof(kPercentiles[0]) && !latencies.empty(); p++) {
+    size_t index = (size_t) ((latencies.size() - 1) * kPercentiles[p] / 100);
+    cout << setw(8) << kPercentileNames[p] << setw(12) << latencies[index] * 1000 << " ms" << endl;
+  }
+  return connected == numConnections ? 0 : 1;
+}
@@ -0,0 +1,157 @@
+#include "query-profile.h"
+#include "imdb-utils.h"
+#include <mutex>
+#include <sstream>
+using namespace std;
+
+static const char *const kCounterNames[NUM_PROFILE_COUNTERS] = {
+  "lookups", "bsearchProbes", "recordsDecoded", "stringsBuilt",
+  "actorsExpanded", "moviesExpanded", "visitedInserts"
+};
+
+static const char *const kStageNames[NUM_PROFILE_STAGES] = {
+  "lookup", "credits", "expand", "path"
+};
+
+static const int kNumBuckets = 32;  // bucket b holds times under 2^b microseconds
+
+bool profilingEnabled = false;
+
+bool setProfiling(bool enabled)
+{
+#ifdef IMDB_PROFILE
+  profilingEnabled = enabled;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void queryProfile::reset()
+{
+  for (int c = 0; c < NUM_PROFILE_COUNTERS; c++) counters[c] = 0;
+  for (int s = 0; s < NUM_PROFILE_STAGES; s++) {
+    stageSeconds[s] = 0;
+    stageCalls[s] = 0;
+  }
+  frontierSizes.clear();
+  visitedActors = 0;
+  visitedMovies = 0;
+}
+
+/**
+ * The process-wide aggregate, guarded by one lock taken once per query.
+ */
+
+static struct {
+  mutex lock;
+  long queries;
+  long counters[NUM_PROFILE_COUNTERS];
+  double stageSeconds[NUM_PROFILE_STAGES];
+  long stageCalls[NUM_PROFILE_STAGES];
+  long histograms[NUM_PROFILE_STAGES][kNumBuckets];
+} aggregate;
+
+queryProfile& currentProfile()
+{
+  static thread_local queryProfile profile;
+  return profile;
+}
+
+void beginQueryProfile()
+{
+  currentProfile().reset();
+}
+
+static int bucketFor(double seconds)
+{
+  double limit = 1e-6;
+  int bucket = 0;
+  while (bucket < kNumBuckets - 1 && seconds >= limit) { limit *= 2; bucket++; }
+  return bucket;
+}
+
+void endQueryProfile()
+{
+  const queryProfile& profile = currentProfile();
+  lock_guard<mutex> guard(aggregate.lock);
+  aggregate.queries++;
+  for (int c = 0; c < NUM_PROFILE_COUNTERS; c++) aggregate.counters[c] += profile.counters[c];
+  for (int s = 0; s < NUM_PROFILE_STAGES; s++) {
+    if (profile.stageCalls[s] == 0) continue;
+    aggregate.stageSeconds[s] += profile.stageSeconds[s];
+    aggregate.stageCalls[s] += profile.stageCalls[s];
+    aggregate.histograms[s][bucketFor(profile.stageSeconds[s])]++;
+  }
+}
+
+void resetAggregateProfile()
+{
+  lock_guard<mutex> guard(aggregate.lock);
+  aggregate.queries = 0;
+  for (int c = 0; c < NUM_PROFILE_COUNTERS; c++) aggregate.counters[c] = 0;
+  for (int s = 0; s < NUM_PROFILE_STAGES; s++) {
+    aggregate.stageSeconds[s] = 0;
+    aggregate.stageCalls[s] = 0;
+    for (int b = 0; b < kNumBuckets; b++) aggregate.histograms[s][b] = 0;
+  }
+}
+
+static void appendCounters(ostringstream& json, const long counters[])
+{
+  json << "\"counters\": {";
+  for (int c = 0; c < NUM_PROFILE_COUNTERS; c++)
+    json << (c > 0 ? ", " : "") << "\"" << kCounterNames[c] << "\": " << counters[c];
+  json << "}";
+}
+
+string profileAsJson(const queryProfile& profile)
+{
+  ostringstream json;
+  json << "{";
+  appendCounters(json, profile.counters);
+  json << ", \"stages\": {";
+  for (int s = 0; s < NUM_PROFILE_STAGES; s++)
+    json << (s > 0 ? ", " : "") << "\"" << kStageNames[s] << "\": {\"ms\": "
+	 << profile.stageSeconds[s] * 1000 << ", \"calls\": " << profile.stageCalls[s] << "}";
+  json << "}, \"frontierSizes\": [";
+  for (size_t i = 0; i < profile.frontierSizes.size(); i++)
+    json << (i > 0 ? ", " : "") << profile.frontierSizes[i];
+  json << "], \"visitedActors\": " << profile.visitedActors
+       << ", \"visitedMovies\": " << profile.visitedMovies << "}";
+  return json.str();
+}
+
+string aggregateProfileAsJson()
+{
+  lock_guard<mutex> guard(aggregate.lock);
+  ostringstream json;
+  json << "{\"queries\": " << aggregate.queries << ", ";
+  appendCounters(json, aggregate.counters);
+  json << ", \"stages\": {";
+  for (int s = 0; s < NUM_PROFILE_STAGES; s++) {
+    json << (s > 0 ? ", " : "") << "\"" << kStageNames[s] << "\": {\"ms\": "
+	 << aggregate.stageSeconds[s] * 1000 << ", \"calls\": " << aggregate.stageCalls[s]
+	 << ", \"histogram\": {";
+    bool first = true;
+    for (int b = 0; b < kNumBuckets; b++) {
+      if (aggregate.histograms[s][b] == 0) continue;
+      json << (first ? "" : ", ") << "\"<" << (1L << b) << "us\": " << aggregate.histograms[s][b];
+      first = false;
+    }
+    json << "}}";
+  }
+  json << "}}";
+  return json.str();
+}
+
+stageTimer::stageTimer(profileStage stage) :
+  stage(stage), start(profilingEnabled ? monotonicSeconds() : -1) {}
+
+stageTimer::~stageTimer()
+{
+  if (start < 0) return;
+  queryProfile& profile = currentProfile();
+  profile.stageSeconds[stage] += monotonicSeconds() - start;
+  profile.stageCalls[stage]++;
+}
@@ -0,0 +1,149 @@
+#ifndef __query_profile__
+#define __query_profile__
+
+#include <string>
+#include <vector>
+using namespace std;
+
+/**
+ * Per-query instrumentation of the imdb and the search engines.  The imdb and
+ * the engines are sprinkled with PROFILE_* macros marking the events and the
+ * stages worth measuring.  Built without IMDB_PROFILE defined (the default;
+ * see the Makefile's PROFILE variable), the macros expand to nothing and cost
+ * nothing.  Built with it, each macro first checks a global switch, so
+ * profiling can be left compiled in and turned on only when wanted.
+ *
+ * Events and stage times are collected per thread into a queryProfile that a
+ * client opens with beginQueryProfile and closes with endQueryProfile, which
+ * also folds it into a process-wide aggregate.  Work a query hands to other
+ * threads (the "parallel" engine's helpers) isn't attributed to it.
+ */
+
+enum profileCounter {
+  PROFILE_LOOKUPS,           /// names and films looked up
+  PROFILE_BSEARCH_PROBES,    /// records compared during binary searches
+  PROFILE_RECORDS_DECODED,   /// record headers parsed (getRecord)
+  PROFILE_STRINGS_BUILT,     /// names and titles copied out into strings
+  PROFILE_ACTORS_EXPANDED,   /// actors whose credits a search fetched
+  PROFILE_MOVIES_EXPANDED,   /// movies whose casts a search fetched
+  PROFILE_VISITED_INSERTS,   /// insertions attempted into a search's visited sets
+  NUM_PROFILE_COUNTERS
+};
+
+enum profileStage {
+  STAGE_LOOKUP,    /// finding one name or film's record
+  STAGE_CREDITS,   /// one getCredits or getCast call that builds strings, lookup included
+  STAGE_EXPAND,    /// expanding one level of a search
+  STAGE_PATH,      /// assembling the path a search found
+  NUM_PROFILE_STAGES
+};
+
+/**
+ * Convenience struct: queryProfile
+ * --------------------------------
+ * Everything recorded about one query: a count of each event, the total
+ * time spent in each stage (stages nest, so a lookup made while expanding
+ * a level counts toward both), the size of the frontier at the start of
+ * each level a search expanded, and the sizes of its visited sets at the end.
+ */
+
+struct queryProfile {
+  long counters[NUM_PROFILE_COUNTERS];
+  double stageSeconds[NUM_PROFILE_STAGES];
+  long stageCalls[NUM_PROFILE_STAGES];
+  vector<long> frontierSizes;
+  long visitedActors;
+  long visitedMovies;
+
+  queryProfile() { reset(); }
+  void reset();
+};
+
+/**
+ * Functions: setProfiling
+ *            isProfiling
+ * ----------------------
+ * Turn profiling on or off at run time, for every thread.  Like the path
+ * length limit, the switch should be set before any queries start.  With
+ * IMDB_PROFILE undefined, setProfiling has no effect and returns false, and
+ * isProfiling is always false.
+ */
+
+extern bool profilingEnabled;
+bool setProfiling(bool enabled);
+inline bool isProfiling() { return profilingEnabled; }
+
+/**
+ * Functions: beginQueryProfile
+ *            endQueryProfile
+ *            currentProfile
+ * ---------------------------
+ * Clear the calling thread's profile before a query, and fold it into the
+ * aggregate afterwards.  currentProfile returns the calling thread's profile,
+ * which stays readable until the next beginQueryProfile.
+ */
+
+void beginQueryProfile();
+void endQueryProfile();
+queryProfile& currentProfile();
+
+/**
+ * Function: resetAggregateProfile
+ * -------------------------------
+ * Empties the aggregate, so that a client can profile several batches
+ * of queries (one per search engine, say) separately.
+ */
+
+void resetAggregateProfile();
+
+/**
+ * Functions: profileAsJson
+ *            aggregateProfileAsJson
+ * --------------------------------
+ * Render one query's profile, or the aggregate of every profile ended so far,
+ * as a single-line JSON object.  The aggregate holds the number of queries,
+ * counter totals, and for each stage the total time, the number of calls, and
+ * a histogram of the time each query spent in it, in power-of-two
+ * microsecond buckets ("<1us", "<2us", "<4us", ...).
+ */
+
+string profileAsJson(const queryProfile& profile);
+string aggregateProfileAsJson();
+
+/**
+ * Class: stageTimer
+ * -----------------
+ * Adds the time between its construction and its destruction to one
+ * stage of the calling thread's profile, if profiling was on when it
+ * was constructed.  Used through PROFILE_STAGE.
+ */
+
+class stageTimer {
+ public:
+  stageTimer(profileStage stage);
+  ~stageTimer();
+
+ private:
+  profileStage stage;
+  double start;
+};
+
+#ifdef IMDB_PROFILE
+#define PROFILE_COUNT(counter) PROFILE_ADD(counter, 1)
+#define PROFILE_ADD(counter, amount) \
+  do { if (profilingEnabled) currentProfile().counters[counter] += (amount); } while (0)
+#define PROFILE_STAGE(stage) stageTimer profileTimer(stage)
+#define PROFILE_FRONTIER(size) \
+  do { if (profilingEnabled) currentProfile().frontierSizes.push_back(size); } while (0)
+#define PROFILE_VISITED(actors, movies) \
+  do { if (profilingEnabled) { currentProfile().visitedActors = (actors); \
+                               currentProfile().visitedMovies = (movies); } } while (0)
+#else
+#define PROFILE_COUNT(counter) ((void) 0)
+#define PROFILE_ADD(counter, amount) ((void) 0)
+#define PROFILE_STAGE(stage) ((void) 0)
+#define PROFILE_FRONTIER(size) ((void) 0)
+#define PROFILE_VISITED(actors, movies) ((void) 0)
+#endif
+
+#endif
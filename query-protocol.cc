@@ -0,0 +1,93 @@
+#include "query-protocol.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <stdint.h>
+using namespace std;
+
+static const size_t kHeaderSize = sizeof(uint32_t);
+
+void encodeFrame(const string& payload, string& buffer)
+{
+  uint32_t length = htonl(payload.size());
+  buffer.append((const char *) &length, kHeaderSize);
+  buffer.append(payload);
+}
+
+int extractFrame(string& buffer, string& payload)
+{
+  if (buffer.size() < kHeaderSize) return 0;
+  uint32_t length;
+  memcpy(&length, buffer.data(), kHeaderSize);
+  length = ntohl(length);
+  if (length > kMaxFrameSize) return -1;
+  if (buffer.size() < kHeaderSize + length) return 0;
+  payload.assign(buffer, kHeaderSize, length);
+  buffer.erase(0, kHeaderSize + length);
+  return 1;
+}
+
+/**
+ * Reads or writes exactly size bytes, retrying after short transfers
+ * and interrupted calls.
+ */
+
+static bool transferFully(int fd, char *data, size_t size, bool writing)
+{
+  while (size > 0) {
+    ssize_t count = writing ? write(fd, data, size) : read(fd, data, size);
+    if (count < 0 && errno == EINTR) continue;
+    if (count <= 0) return false;
+    data += count;
+    size -= count;
+  }
+  return true;
+}
+
+bool sendFrame(int fd, const string& payload)
+{
+  string frame;
+  encodeFrame(payload, frame);
+  return transferFully(fd, &frame[0], frame.size(), true);
+}
+
+bool receiveFrame(int fd, string& payload)
+{
+  uint32_t length;
+  if (!transferFully(fd, (char *) &length, kHeaderSize, false)) return false;
+  length = ntohl(length);
+  if (length > kMaxFrameSize) return false;
+  payload.resize(length);
+  return length == 0 || transferFully(fd, &payload[0], length, false);
+}
+
+int connectToServer(const string& socketPath)
+{
+  struct sockaddr_un address;
+  if (socketPath.size() >= sizeof(address.sun_path)) return -1;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strcpy(address.sun_path, socketPath.c_str());
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd == -1) return -1;
+  if (connect(fd, (struct sockaddr *) &address, sizeof(address)) == -1) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+void splitFields(const string& text, char separator, vector<string>& fields)
+{
+  fields.clear();
+  size_t start = 0;
+  while (true) {
+    size_t end = text.find(separator, start);
+    fields.push_back(text.substr(start, end == string::npos ? string::npos : end - start));
+    if (end == string::npos) return;
+    start = end + 1;
+  }
+}
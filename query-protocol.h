@@ -0,0 +1,87 @@
+#ifndef __query_protocol__
+#define __query_protocol__
+
+#include <string>
+#include <vector>
+using namespace std;
+
+/**
+ * The query protocol spoken by six-degrees --serve (see query-server.h) over a
+ * Unix domain stream socket.  Every query and every reply is one frame: a
+ * 32-bit payload length in network byte order, followed by that many bytes of
+ * payload.  A payload is a list of fields separated by tabs.  Queries are
+ *
+ *     path     <tab> actor <tab> actor
+ *     credits  <tab> actor
+ *     cast     <tab> title <tab> year
+ *     costars  <tab> actor
+ *
+ * and every reply begins with a status line, "ok" or "error <tab> message".
+ * After "ok" come the rows of the answer, one per line:
+ *
+ *     path     the start actor, then one "title <tab> year <tab> actor" line
+ *              per connection (no rows at all if there's no path)
+ *     credits  "title <tab> year" for each movie
+ *     cast     each actor's name
+ *     costars  "actor <tab> number of shared films" for each co-star
+ *
+ * A client may send any number of queries before reading replies; each
+ * connection's replies come back in the order its queries were sent.
+ */
+
+static const char *const kDefaultSocketPath = "/tmp/six-degrees.sock";
+static const size_t kMaxFrameSize = 64 << 20;
+
+/**
+ * Function: encodeFrame
+ * ---------------------
+ * Appends the frame carrying the specified payload to buffer.
+ */
+
+void encodeFrame(const string& payload, string& buffer);
+
+/**
+ * Function: extractFrame
+ * ----------------------
+ * Removes the first complete frame from the front of buffer, which holds
+ * bytes read from a socket, and sets payload to what it carried.
+ *
+ * @return 1 if a frame was extracted, 0 if buffer doesn't yet hold a whole
+ *         frame, or -1 if the frame announced is longer than kMaxFrameSize.
+ */
+
+int extractFrame(string& buffer, string& payload);
+
+/**
+ * Functions: sendFrame
+ *            receiveFrame
+ * -----------------------
+ * Blocking counterparts to encodeFrame and extractFrame, for clients that
+ * hold a connection open and wait on each reply.
+ *
+ * @return true if and only if a whole frame was written or read.
+ */
+
+bool sendFrame(int fd, const string& payload);
+bool receiveFrame(int fd, string& payload);
+
+/**
+ * Function: connectToServer
+ * -------------------------
+ * Opens a connection to the server listening on the named socket.
+ *
+ * @return the connected socket, or -1 if the connection failed.
+ */
+
+int connectToServer(const string& socketPath);
+
+/**
+ * Function: splitFields
+ * ---------------------
+ * Splits text at every occurrence of separator ('\t' between fields,
+ * '\n' between rows) into fields.
+ */
+
+void splitFields(const string& text, char separator, vector<string>& fields);
+
+#endif
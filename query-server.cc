@@ -0,0 +1,336 @@
+#include "query-server.h"
+#include "query-protocol.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <stdint.h>
+using namespace std;
+
+// epoll tags for the three descriptors that aren't client connections
+static const long kListenTag = -1;
+static const long kWakeTag = -2;
+static const long kSignalTag = -3;
+static const int kMaxEvents = 64;
+static const size_t kReadSize = 64 << 10;
+
+queryServer::queryServer(const imdb& db, searchEngine search, const movieFilter *filter,
+			 int numWorkers) :
+  db(db), search(search), filter(filter), numWorkers(numWorkers), epollFd(-1), wakeFd(-1),
+  nextConnection(0), numConnections(0), numQueries(0), stopping(false) {}
+
+static void watch(int epollFd, int op, int fd, long tag, uint32_t events)
+{
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = events;
+  event.data.u64 = tag;
+  epoll_ctl(epollFd, op, fd, &event);
+}
+
+/**
+ * Binds a non-blocking listening socket to the named path, replacing
+ * any socket file a previous server left behind.
+ *
+ * @return the listening socket, or -1 on failure.
+ */
+
+static int listenOn(const string& socketPath)
+{
+  struct sockaddr_un address;
+  if (socketPath.size() >= sizeof(address.sun_path)) return -1;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strcpy(address.sun_path, socketPath.c_str());
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd == -1) return -1;
+  unlink(socketPath.c_str());
+  if (bind(fd, (struct sockaddr *) &address, sizeof(address)) == -1 ||
+      listen(fd, SOMAXCONN) == -1) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/**
+ * SIGINT and SIGTERM are blocked in every thread before the workers start,
+ * and delivered to the loop through a signalfd instead, so a signal ends the
+ * loop cleanly rather than interrupting a worker halfway through a query.
+ */
+
+int queryServer::serve(const string& socketPath)
+{
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, NULL);
+  int signalFd = signalfd(-1, &signals, SFD_CLOEXEC);
+
+  int listenFd = listenOn(socketPath);
+  if (listenFd == -1) {
+    cerr << "Couldn't listen on \"" << socketPath << "\": " << strerror(errno) << endl;
+    close(signalFd);
+    return 1;
+  }
+  epollFd = epoll_create1(EPOLL_CLOEXEC);
+  wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  watch(epollFd, EPOLL_CTL_ADD, listenFd, kListenTag, EPOLLIN);
+  watch(epollFd, EPOLL_CTL_ADD, wakeFd, kWakeTag, EPOLLIN);
+  watch(epollFd, EPOLL_CTL_ADD, signalFd, kSignalTag, EPOLLIN);
+
+  pool.reset(new workerPool(numWorkers));
+  thread workers([this] { pool->run([this](int worker) { workerLoop(); }); });
+  cerr << "Serving queries on " << socketPath << " with " << pool->size() << " workers." << endl;
+
+  double start = monotonicSeconds();
+  struct epoll_event events[kMaxEvents];
+  bool running = true;
+  while (running) {
+    int numEvents = epoll_wait(epollFd, events, kMaxEvents, -1);
+    if (numEvents == -1 && errno == EINTR) continue;
+    for (int i = 0; i < numEvents; i++) {
+      long tag = events[i].data.u64;
+      if (tag == kListenTag) acceptConnections(listenFd);
+      else if (tag == kWakeTag) collectReplies();
+      else if (tag == kSignalTag) running = false;
+      else {
+	map<long, connection>::iterator found = connections.find(tag);
+	if (found == connections.end()) continue;
+	bool open = !(events[i].events & (EPOLLERR | EPOLLHUP)) || (events[i].events & EPOLLIN);
+	if (open && (events[i].events & EPOLLIN)) open = readQueries(tag, found->second);
+	if (open && (events[i].events & EPOLLOUT)) open = writeReplies(tag, found->second);
+	if (!open) closeConnection(tag);
+      }
+    }
+  }
+  double elapsed = monotonicSeconds() - start;
+
+  {
+    lock_guard<mutex> guard(lock);
+    stopping = true;
+  }
+  jobReady.notify_all();
+  workers.join();
+  while (!connections.empty()) closeConnection(connections.begin()->first);
+  close(listenFd);
+  close(wakeFd);
+  close(signalFd);
+  close(epollFd);
+  unlink(socketPath.c_str());
+  cerr << "Answered " << numQueries << " queries from " << numConnections << " connections in "
+       << elapsed << " s." << endl;
+  return 0;
+}
+
+void queryServer::workerLoop()
+{
+  while (true) {
+    job next;
+    {
+      unique_lock<mutex> guard(lock);
+      while (!stopping && jobs.empty()) jobReady.wait(guard);
+      if (stopping) return;
+      next = move(jobs.front());
+      jobs.pop_front();
+    }
+    next.payload = answerQuery(next.payload);
+    {
+      lock_guard<mutex> guard(lock);
+      replies.push_back(move(next));
+    }
+    uint64_t one = 1;
+    if (write(wakeFd, &one, sizeof(one)) != sizeof(one)) continue; // the loop is already awake
+  }
+}
+
+void queryServer::acceptConnections(int listenFd)
+{
+  while (true) {
+    int fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd == -1) return;
+    long id = nextConnection++;
+    connection& client = connections[id];
+    client.fd = fd;
+    client.written = 0;
+    client.busy = false;
+    client.writing = false;
+    client.reading = true;
+    watch(epollFd, EPOLL_CTL_ADD, fd, id, EPOLLIN);
+    numConnections++;
+  }
+}
+
+/**
+ * Reads everything the client has sent, queues every complete query, and
+ * hands the first to the workers if none is with them already.  Once the
+ * client shuts down its sending side, the connection stops being watched for
+ * input but stays open until every query it sent has been answered.
+ *
+ * @return false if the connection failed, the client sent an oversized
+ *         frame, or the client has shut down and is owed nothing more.
+ */
+
+bool queryServer::readQueries(long id, connection& client)
+{
+  char buffer[kReadSize];
+  while (true) {
+    ssize_t count = read(client.fd, buffer, sizeof(buffer));
+    if (count > 0) client.input.append(buffer, count);
+    else if (count == 0) {
+      client.reading = false;
+      break;
+    }
+    else if (errno == EINTR) continue;
+    else if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+    else return false;
+  }
+  string payload;
+  int status;
+  while ((status = extractFrame(client.input, payload)) == 1) client.queries.push_back(payload);
+  if (status == -1) return false;
+  dispatch(id, client);
+  if (!client.reading) rewatch(id, client);
+  return !client.done();
+}
+
+void queryServer::dispatch(long id, connection& client)
+{
+  if (client.busy || client.queries.empty()) return;
+  client.busy = true;
+  job next;
+  next.connection = id;
+  next.payload = move(client.queries.front());
+  client.queries.pop_front();
+  {
+    lock_guard<mutex> guard(lock);
+    jobs.push_back(move(next));
+  }
+  jobReady.notify_one();
+}
+
+void queryServer::rewatch(long id, connection& client)
+{
+  watch(epollFd, EPOLL_CTL_MOD, client.fd, id,
+	(client.reading ? EPOLLIN : 0) | (client.writing ? EPOLLOUT : 0));
+}
+
+/**
+ * Sends as much pending output as the socket will take, and asks epoll to
+ * report when it can take more only while some is left over.
+ *
+ * @return false if the connection failed, or if the client has shut down
+ *         and everything it's owed has now been sent.
+ */
+
+bool queryServer::writeReplies(long id, connection& client)
+{
+  while (client.written < client.output.size()) {
+    ssize_t count = send(client.fd, client.output.data() + client.written,
+			 client.output.size() - client.written, MSG_NOSIGNAL);
+    if (count >= 0) client.written += count;
+    else if (errno == EINTR) continue;
+    else if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+    else return false;
+  }
+  if (client.written == client.output.size()) {
+    client.output.clear();
+    client.written = 0;
+  }
+  bool writing = !client.output.empty();
+  if (writing != client.writing) {
+    client.writing = writing;
+    rewatch(id, client);
+  }
+  return !client.done();
+}
+
+/**
+ * Frames every reply the workers have posted since the last wakeup onto its
+ * connection's output, and passes that connection's next query along.
+ * Replies to connections that have since closed are dropped.
+ */
+
+void queryServer::collectReplies()
+{
+  uint64_t count;
+  if (read(wakeFd, &count, sizeof(count)) != sizeof(count)) return;
+  deque<job> ready;
+  {
+    lock_guard<mutex> guard(lock);
+    ready.swap(replies);
+  }
+  for (size_t i = 0; i < ready.size(); i++) {
+    map<long, connection>::iterator found = connections.find(ready[i].connection);
+    if (found == connections.end()) continue;
+    connection& client = found->second;
+    encodeFrame(ready[i].payload, client.output);
+    client.busy = false;
+    numQueries++;
+    dispatch(found->first, client);
+    if (!writeReplies(found->first, client)) closeConnection(found->first);
+  }
+}
+
+void queryServer::closeConnection(long id)
+{
+  map<long, connection>::iterator found = connections.find(id);
+  if (found == connections.end()) return;
+  epoll_ctl(epollFd, EPOLL_CTL_DEL, found->second.fd, NULL);
+  close(found->second.fd);
+  connections.erase(found);
+}
+
+string queryServer::answerQuery(const string& query) const
+{
+  vector<string> fields;
+  splitFields(query, '\t', fields);
+  const string& command = fields[0];
+  string reply = "ok";
+  if (command == "path" && fields.size() == 3) {
+    for (int i = 1; i <= 2; i++)
+      if (db.getActorRecord(fields[i]) == -1)
+	return "error\t\"" + fields[i] + "\" isn't in the database";
+    path found = filter != NULL ? getShortestPathFiltered(fields[1], fields[2], db, *filter) :
+      search(fields[1], fields[2], db, NULL);
+    if (found.getLastPlayer() == "") return reply;
+    reply += "\n" + found.getPlayer(0);
+    for (int i = 0; i < found.getLength(); i++) {
+      const film& movie = found.getMovie(i);
+      reply += "\n" + movie.title + "\t" + to_string(movie.year) + "\t" + found.getPlayer(i + 1);
+    }
+  } else if (command == "credits" && fields.size() == 2) {
+    vector<film> credits;
+    if (!db.getCredits(fields[1], credits))
+      return "error\t\"" + fields[1] + "\" isn't in the database";
+    for (size_t i = 0; i < credits.size(); i++)
+      reply += "\n" + credits[i].title + "\t" + to_string(credits[i].year);
+  } else if (command == "cast" && fields.size() == 3) {
+    film movie;
+    movie.title = fields[1];
+    movie.year = atoi(fields[2].c_str());
+    vector<string> cast;
+    if (!db.getCast(movie, cast))
+      return "error\t\"" + fields[1] + "\" (" + fields[2] + ") isn't in the database";
+    for (size_t i = 0; i < cast.size(); i++) reply += "\n" + cast[i];
+  } else if (command == "costars" && fields.size() == 2) {
+    vector<imdb::costar> costars;
+    if (!db.getCostars(fields[1], costars))
+      return "error\t\"" + fields[1] + "\" isn't in the database";
+    for (size_t i = 0; i < costars.size(); i++)
+      reply += "\n" + db.getActorName(costars[i].actor) + "\t" + to_string(costars[i].sharedFilms);
+  } else {
+    return "error\tunrecognized query \"" + command + "\"";
+  }
+  return reply;
+}
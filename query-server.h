@@ -0,0 +1,118 @@
+#ifndef __query_server__
+#define __query_server__
+
+#include "imdb.h"
+#include "shortest-path.h"
+#include "movie-filter.h"
+#include "worker-pool.h"
+#include <string>
+#include <memory>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+using namespace std;
+
+/**
+ * Class: queryServer
+ * ------------------
+ * Serves path, credits, cast, and co-star queries against one imdb over a
+ * Unix domain socket, speaking the framed protocol of query-protocol.h.  The
+ * imdb is opened (and warmed) once and then shared by every query, so clients
+ * pay nothing for startup.
+ *
+ * One thread runs an epoll loop that accepts connections, reads and writes
+ * frames without blocking, and hands each complete query to a workerPool.
+ * The workers answer queries one at a time from a shared queue, and post each
+ * reply back to the loop through an eventfd.  A connection has at most one
+ * query with the workers at a time, which keeps its replies in order; further
+ * queries it sends wait in its own queue.  A client that shuts down its
+ * sending side still gets a reply to every query it sent before the
+ * connection is closed.
+ */
+
+class queryServer {
+ public:
+
+  /**
+   * Constructor: queryServer
+   * ------------------------
+   * Prepares to answer queries against db, finding paths with search (or,
+   * if filter isn't NULL, with getShortestPathFiltered), using numWorkers
+   * worker threads.  db and filter must outlive the server.
+   */
+
+  queryServer(const imdb& db, searchEngine search, const movieFilter *filter, int numWorkers);
+
+  /**
+   * Method: serve
+   * -------------
+   * Listens on the named socket (replacing any stale socket file left there)
+   * and serves queries until the process receives SIGINT or SIGTERM, then
+   * removes the socket file and prints a summary of the work done on cerr.
+   *
+   * @return the program's exit status: 0, or 1 if the socket couldn't be set up.
+   */
+
+  int serve(const string& socketPath);
+
+  /**
+   * Method: answerQuery
+   * -------------------
+   * Answers one query payload with its reply payload.  Safe to call from any
+   * number of threads at once.
+   */
+
+  string answerQuery(const string& query) const;
+
+ private:
+  struct connection {
+    int fd;
+    string input;
+    string output;
+    size_t written;  // bytes of output already sent
+    deque<string> queries;
+    bool busy;       // a query of this connection is with the workers
+    bool writing;    // the loop is waiting for the socket to drain
+    bool reading;    // the client hasn't shut down its sending side
+    bool done() const { return !reading && !busy && queries.empty() && output.empty(); }
+  };
+
+  struct job {
+    long connection;
+    string payload;
+  };
+
+  const imdb& db;
+  searchEngine search;
+  const movieFilter *filter;
+  int numWorkers;
+  unique_ptr<workerPool> pool;
+
+  int epollFd;
+  int wakeFd;
+  map<long, connection> connections;
+  long nextConnection;
+  long numConnections;
+  long numQueries;
+
+  mutex lock;
+  condition_variable jobReady;
+  deque<job> jobs;
+  deque<job> replies;
+  bool stopping;
+
+  void workerLoop();
+  void acceptConnections(int listenFd);
+  bool readQueries(long id, connection& client);
+  bool writeReplies(long id, connection& client);
+  void dispatch(long id, connection& client);
+  void rewatch(long id, connection& client);
+  void collectReplies();
+  void closeConnection(long id);
+
+  queryServer(const queryServer& original);
+  queryServer& operator=(const queryServer& rhs);
+};
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef __record_set__
+#define __record_set__
+
+#include "imdb.h"
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+using namespace std;
+
+/**
+ * Class: recordSet
+ * ----------------
+ * A flat bitset over the records of one imdb data file.  Because every
+ * record begins on an imdb::kRecordAlignment boundary, a record offset
+ * divided by that alignment is a dense record number, and membership is
+ * one bit at that position.  Inserting and testing cost a shift and a
+ * mask, with none of the allocation a set<string> or set<film> needs.
+ */
+
+class recordSet {
+ public:
+
+  /**
+   * Constructor: recordSet
+   * ----------------------
+   * Constructs an empty set able to hold any record of a file
+   * of the specified size (see imdb::getFileSize).
+   */
+
+  recordSet(size_t fileSize) :
+    bits((fileSize / imdb::kRecordAlignment + kBitsPerWord - 1) / kBitsPerWord, 0) {}
+
+  /**
+   * Method: insert
+   * --------------
+   * Adds the record at the specified offset to the set.
+   *
+   * @return true if and only if the record wasn't already present.
+   */
+
+  bool insert(int record) {
+    size_t slot = record / imdb::kRecordAlignment;
+    uint64_t mask = (uint64_t) 1 << (slot % kBitsPerWord);
+    uint64_t& word = bits[slot / kBitsPerWord];
+    if (word & mask) return false;
+    word |= mask;
+    return true;
+  }
+
+  /**
+   * Method: contains
+   * ----------------
+   * Returns true if and only if the record at the specified offset is present.
+   */
+
+  bool contains(int record) const {
+    size_t slot = record / imdb::kRecordAlignment;
+    return (bits[slot / kBitsPerWord] >> (slot % kBitsPerWord)) & 1;
+  }
+
+  /**
+   * Method: erase
+   * -------------
+   * Removes the record at the specified offset from the set.  A set that's
+   * reused from one search to the next is emptied by erasing just the records
+   * the last search inserted, rather than by clearing every word.
+   */
+
+  void erase(int record) {
+    size_t slot = record / imdb::kRecordAlignment;
+    bits[slot / kBitsPerWord] &= ~((uint64_t) 1 << (slot % kBitsPerWord));
+  }
+
+  /**
+   * Method: unite
+   * -------------
+   * Adds every record of other, a set built for a file of the same size,
+   * one 64-bit word at a time.
+   */
+
+  void unite(const recordSet& other) {
+    for (size_t i = 0; i < bits.size(); i++) bits[i] |= other.bits[i];
+  }
+
+ private:
+  static const size_t kBitsPerWord = 64;
+  vector<uint64_t> bits;
+};
+
+/**
+ * Class: atomicRecordSet
+ * ----------------------
+ * A recordSet that any number of threads can insert into at once.  insert
+ * is an atomic test-and-set, so when several threads race to insert the
+ * same record, exactly one of them is told it got there first.
+ */
+
+class atomicRecordSet {
+ public:
+  atomicRecordSet(size_t fileSize) :
+    numWords((fileSize / imdb::kRecordAlignment + kBitsPerWord - 1) / kBitsPerWord),
+    bits(new atomic<uint64_t>[numWords]) {
+    for (size_t i = 0; i < numWords; i++) bits[i].store(0, memory_order_relaxed);
+  }
+
+  /**
+   * Method: insert
+   * --------------
+   * Adds the record at the specified offset to the set.  The bit is read
+   * before it's set, so records already present cost no cache line traffic.
+   *
+   * @return true if and only if the record wasn't already present.
+   */
+
+  bool insert(int record) {
+    size_t slot = record / imdb::kRecordAlignment;
+    uint64_t mask = (uint64_t) 1 << (slot % kBitsPerWord);
+    atomic<uint64_t>& word = bits[slot / kBitsPerWord];
+    if (word.load(memory_order_relaxed) & mask) return false;
+    return (word.fetch_or(mask, memory_order_relaxed) & mask) == 0;
+  }
+
+  bool contains(int record) const {
+    size_t slot = record / imdb::kRecordAlignment;
+    return (bits[slot / kBitsPerWord].load(memory_order_relaxed) >> (slot % kBitsPerWord)) & 1;
+  }
+
+ private:
+  static const size_t kBitsPerWord = 64;
+  size_t numWords;
+  unique_ptr<atomic<uint64_t>[]> bits;
+};
+
+#endif
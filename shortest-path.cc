@@ -0,0 +1,837 @@
+#include <vector>
+#include <set>
+#include <map>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <memory>
+#include "shortest-path.h"
+#include "record-set.h"
+#include "query-profile.h"
+using namespace std;
+
+static int maxPathLength = kDefaultMaxPathLength;
+
+void setMaxPathLength(int length)
+{
+  maxPathLength = length;
+}
+
+int getMaxPathLength()
+{
+  return maxPathLength;
+}
+
+/**
+ * Convenience struct recording one actor discovered by the one-sided search.
+ * Rather than carrying a full path around, each node remembers only the
+ * index of the node it was reached from and the index (within the vector
+ * of expanded films) of the movie linking the two.  The root has neither.
+ */
+
+struct bfsNode {
+  string actor;
+  int movie;
+  int parent;
+
+  bfsNode(const string& actor, int movie, int parent) :
+    actor(actor), movie(movie), parent(parent) {}
+};
+
+/**
+ * Rebuilds the path leading to the specified node by following parent
+ * indices back to the root and then reversing the result.
+ */
+
+static path buildPath(const vector<bfsNode>& nodes, const vector<film>& films, int index)
+{
+  path result(nodes[index].actor);
+  for (; nodes[index].parent != -1; index = nodes[index].parent)
+    result.addConnection(films[nodes[index].movie], nodes[nodes[index].parent].actor);
+  result.reverse();
+  return result;
+}
+
+/**
+ * The frontier is a vector of node indices holding one whole level, and the
+ * next level collects in a second vector that's swapped in once the current
+ * one is exhausted, so the depth is just the number of swaps so far.
+ */
+
+path getShortestPath(const string& startActor, const string& goalActor,
+		     const imdb& db, searchStats *stats){
+  if (startActor == goalActor) return path(startActor);
+  vector<bfsNode> nodes;
+  vector<film> expandedFilms;
+  vector<int> frontier, next;
+  set<string> previouslySeenActors;
+  set<film> previouslySeenFilms;
+  nodes.push_back(bfsNode(startActor, -1, -1));
+  previouslySeenActors.insert(startActor);
+  frontier.push_back(0);
+  for (int depth = 0; !frontier.empty() && depth < maxPathLength; depth++) {
+    PROFILE_STAGE(STAGE_EXPAND);
+    PROFILE_FRONTIER(frontier.size());
+    for (size_t f = 0; f < frontier.size(); f++) {
+      int current = frontier[f];
+      vector<film> thisActorMovies;
+      db.getCredits(nodes[current].actor, thisActorMovies);
+      if (stats != NULL) stats->actorsExpanded++;
+      PROFILE_COUNT(PROFILE_ACTORS_EXPANDED);
+      for(unsigned int i = 0; i < thisActorMovies.size(); i++){
+	const film& currMovie = thisActorMovies[i];
+	PROFILE_COUNT(PROFILE_VISITED_INSERTS);
+	if (previouslySeenFilms.insert(currMovie).second){
+	  int movieIndex = expandedFilms.size();
+	  expandedFilms.push_back(currMovie);
+	  vector<string> otherActors;
+	  db.getCast(currMovie, otherActors);
+	  if (stats != NULL) stats->moviesExpanded++;
+	  PROFILE_COUNT(PROFILE_MOVIES_EXPANDED);
+	  for(unsigned int j= 0; j < otherActors.size(); j++){
+	    const string& otherActor = otherActors[j];
+	    PROFILE_COUNT(PROFILE_VISITED_INSERTS);
+	    if(previouslySeenActors.insert(otherActor).second){
+	      nodes.push_back(bfsNode(otherActor, movieIndex, current));
+	      if(otherActor == goalActor) {
+		PROFILE_VISITED(previouslySeenActors.size(), previouslySeenFilms.size());
+		PROFILE_STAGE(STAGE_PATH);
+		return buildPath(nodes, expandedFilms, nodes.size() - 1);
+	      }
+	      next.push_back(nodes.size() - 1);
+	    }
+	  }
+	}
+      }
+    }
+    frontier.swap(next);
+    next.clear();
+  }
+  PROFILE_VISITED(previouslySeenActors.size(), previouslySeenFilms.size());
+  path returnPath = path("");
+  return returnPath;
+}
+
+/**
+ * Convenience struct recording how an actor was first reached from
+ * one end of a bidirectional search: the movie and the previously
+ * discovered actor that lead to it, and how many movies away from
+ * that end of the search it sits.
+ */
+
+struct parentLink {
+  film movie;
+  string previous;
+  int depth;
+
+  parentLink() : depth(0) {}
+  parentLink(const film& movie, const string& previous, int depth) :
+    movie(movie), previous(previous), depth(depth) {}
+};
+
+/**
+ * Everything one end of a bidirectional search knows: every actor
+ * it's discovered (with the link back toward its root), the films
+ * whose casts it has already expanded, and the actors discovered
+ * most recently, which make up its frontier.
+ */
+
+struct searchSide {
+  map<string, parentLink> parents;
+  set<film> seenFilms;
+  vector<string> frontier;
+  int depth;
+
+  searchSide(const string& root) : depth(0) {
+    parents[root] = parentLink();
+    frontier.push_back(root);
+  }
+};
+
+/**
+ * Expands every actor in the frontier of the specified side by one movie,
+ * replacing the frontier with the newly discovered actors.  Whenever a newly
+ * discovered actor has already been discovered by the other side, the total
+ * length of the path through it is compared against the best meeting point so far.
+ *
+ * @param side the end of the search being advanced.
+ * @param other the opposite end of the search, consulted for meeting points.
+ * @param db the imdb consulted for credits and casts.
+ * @param stats if non-NULL, updated with the amount of work done.
+ * @param meet updated to the actor at the best meeting point seen so far.
+ * @param bestLength updated to the length of the path through meet.
+ */
+
+static void expandLevel(searchSide& side, const searchSide& other, const imdb& db,
+			searchStats *stats, string& meet, int& bestLength)
+{
+  PROFILE_STAGE(STAGE_EXPAND);
+  PROFILE_FRONTIER(side.frontier.size());
+  vector<string> next;
+  for (unsigned int i = 0; i < side.frontier.size(); i++) {
+    const string& actor = side.frontier[i];
+    vector<film> credits;
+    db.getCredits(actor, credits);
+    if (stats != NULL) stats->actorsExpanded++;
+    PROFILE_COUNT(PROFILE_ACTORS_EXPANDED);
+    for (unsigned int j = 0; j < credits.size(); j++) {
+      const film& movie = credits[j];
+      PROFILE_COUNT(PROFILE_VISITED_INSERTS);
+      if (!side.seenFilms.insert(movie).second) continue;
+      vector<string> cast;
+      db.getCast(movie, cast);
+      if (stats != NULL) stats->moviesExpanded++;
+      PROFILE_COUNT(PROFILE_MOVIES_EXPANDED);
+      for (unsigned int k = 0; k < cast.size(); k++) {
+	const string& costar = cast[k];
+	parentLink link(movie, actor, side.depth + 1);
+	PROFILE_COUNT(PROFILE_VISITED_INSERTS);
+	if (!side.parents.insert(make_pair(costar, link)).second) continue;
+	next.push_back(costar);
+	map<string, parentLink>::const_iterator found = other.parents.find(costar);
+	if (found != other.parents.end() && link.depth + found->second.depth < bestLength) {
+	  bestLength = link.depth + found->second.depth;
+	  meet = costar;
+	}
+      }
+    }
+  }
+  side.frontier.swap(next);
+  side.depth++;
+}
+
+/**
+ * Once the two ends of the search have met, the path is assembled by
+ * walking from the meeting point back toward the start actor, reversing
+ * that half, and then walking from the meeting point toward the goal.
+ */
+
+path getShortestPathBidirectional(const string& startActor, const string& goalActor,
+				  const imdb& db, searchStats *stats)
+{
+  if (startActor == goalActor) return path(startActor);
+
+  searchSide forward(startActor), backward(goalActor);
+  string meet;
+  int bestLength = maxPathLength + 1;
+  while (!forward.frontier.empty() && !backward.frontier.empty() &&
+	 forward.depth + backward.depth < maxPathLength) {
+    if (forward.frontier.size() <= backward.frontier.size())
+      expandLevel(forward, backward, db, stats, meet, bestLength);
+    else
+      expandLevel(backward, forward, db, stats, meet, bestLength);
+    if (bestLength <= maxPathLength) break;
+  }
+  PROFILE_VISITED(forward.parents.size() + backward.parents.size(),
+		  forward.seenFilms.size() + backward.seenFilms.size());
+  if (bestLength > maxPathLength) return path("");
+
+  PROFILE_STAGE(STAGE_PATH);
+  path result(meet);
+  for (string curr = meet; curr != startActor; ) {
+    const parentLink& link = forward.parents[curr];
+    result.addConnection(link.movie, link.previous);
+    curr = link.previous;
+  }
+  result.reverse();
+  for (string curr = meet; curr != goalActor; ) {
+    const parentLink& link = backward.parents[curr];
+    result.addConnection(link.movie, link.previous);
+    curr = link.previous;
+  }
+  return result;
+}
+
+/**
+ * Convenience struct recording one actor discovered by the record-level
+ * search: the actor's record, the record of the movie that lead to it,
+ * and the index (within the same vector of nodes) of the actor it was
+ * reached from.  The root of a search has no movie and no parent.
+ */
+
+struct recordNode {
+  int actor;
+  int movie;
+  int parent;
+
+  recordNode(int actor, int movie, int parent) : actor(actor), movie(movie), parent(parent) {}
+};
+
+/**
+ * The record-level counterpart to searchSide.  Visited actors and movies
+ * are bitsets indexed by record, and nodes lists every discovered actor in
+ * the order it was discovered, so the frontier is simply the tail of nodes
+ * beginning at levelStart.  movies lists every movie in seenMovies.
+ *
+ * A recordSide outlives any one search: reset empties it by erasing only
+ * the actors and movies the previous search touched, and its vectors keep
+ * their capacity, so a warmed-up side answers a query without allocating.
+ */
+
+struct recordSide {
+  size_t actorFileSize;
+  size_t movieFileSize;
+  recordSet seenActors;
+  recordSet seenMovies;
+  vector<recordNode> nodes;
+  vector<int> movies;
+  size_t levelStart;
+  int depth;
+
+  recordSide(const imdb& db) :
+    actorFileSize(db.getFileSize(imdb::ACTOR)), movieFileSize(db.getFileSize(imdb::MOVIE)),
+    seenActors(actorFileSize), seenMovies(movieFileSize), levelStart(0), depth(0) {}
+
+  bool fits(const imdb& db) const {
+    return actorFileSize == db.getFileSize(imdb::ACTOR) && movieFileSize == db.getFileSize(imdb::MOVIE);
+  }
+
+  void reset(int root) {
+    for (size_t i = 0; i < nodes.size(); i++) seenActors.erase(nodes[i].actor);
+    for (size_t i = 0; i < movies.size(); i++) seenMovies.erase(movies[i]);
+    nodes.clear();
+    movies.clear();
+    levelStart = 0;
+    depth = 0;
+    seenActors.insert(root);
+    nodes.push_back(recordNode(root, -1, -1));
+  }
+
+  size_t frontierSize() const { return nodes.size() - levelStart; }
+};
+
+/**
+ * Hands back the calling thread's two record-level sides, reset to search
+ * from startRecord and goalRecord.  They're rebuilt only when db's files
+ * differ in size from those they were last built for.
+ */
+
+static void acquireRecordSides(const imdb& db, int startRecord, int goalRecord,
+			       recordSide *& forward, recordSide *& backward)
+{
+  static thread_local unique_ptr<recordSide> sides[2];
+  for (int i = 0; i < 2; i++)
+    if (!sides[i] || !sides[i]->fits(db)) sides[i].reset(new recordSide(db));
+  forward = sides[0].get();
+  backward = sides[1].get();
+  forward->reset(startRecord);
+  backward->reset(goalRecord);
+}
+
+/**
+ * Record-level counterpart to expandLevel.  Because levels are always
+ * expanded in full, the first actor found to have been discovered by both
+ * sides lies on a shortest path, so expansion stops there.  If filter isn't
+ * NULL, movies it rejects are marked seen (so each is tested only once) but
+ * never expanded.
+ *
+ * @return the index within side.nodes of the meeting point, or -1 if the
+ *         two sides haven't met yet.
+ */
+
+static int expandRecordLevel(recordSide& side, const recordSide& other,
+			     const imdb& db, const movieFilter *filter, searchStats *stats)
+{
+  PROFILE_STAGE(STAGE_EXPAND);
+  PROFILE_FRONTIER(side.frontierSize());
+  size_t levelEnd = side.nodes.size();
+  for (size_t i = side.levelStart; i < levelEnd; i++) {
+    offsetArray movies;
+    int numMovies = db.getCreditRecords(side.nodes[i].actor, movies);
+    if (stats != NULL) stats->actorsExpanded++;
+    PROFILE_COUNT(PROFILE_ACTORS_EXPANDED);
+    PROFILE_ADD(PROFILE_VISITED_INSERTS, numMovies);
+    for (int j = 0; j < numMovies; j++) {
+      if (!side.seenMovies.insert(movies[j])) continue;
+      side.movies.push_back(movies[j]);
+      if (filter != NULL && !filter->allows(movies[j])) continue;
+      offsetArray cast;
+      int castSize = db.getCastRecords(movies[j], cast);
+      if (stats != NULL) stats->moviesExpanded++;
+      PROFILE_COUNT(PROFILE_MOVIES_EXPANDED);
+      PROFILE_ADD(PROFILE_VISITED_INSERTS, castSize);
+      for (int k = 0; k < castSize; k++) {
+	if (!side.seenActors.insert(cast[k])) continue;
+	side.nodes.push_back(recordNode(cast[k], movies[j], i));
+	if (other.seenActors.contains(cast[k])) return side.nodes.size() - 1;
+      }
+    }
+  }
+  side.levelStart = levelEnd;
+  side.depth++;
+  return -1;
+}
+
+/**
+ * Appends to result the chain of connections leading from the specified
+ * node back to the root of its side of the search.
+ */
+
+static void appendRecordChain(path& result, const vector<recordNode>& nodes,
+			      int index, const imdb& db)
+{
+  for (; nodes[index].parent != -1; index = nodes[index].parent)
+    result.addConnection(db.getMovie(nodes[index].movie),
+			 db.getActorName(nodes[nodes[index].parent].actor));
+}
+
+/**
+ * Joins the two halves of a record-level search at the actor where they met:
+ * the chain from the meeting point back to the start actor is built and
+ * reversed, and then the chain from the meeting point to the goal is appended.
+ */
+
+static path joinRecordChains(const vector<recordNode>& forward, const vector<recordNode>& backward,
+			     int meetRecord, const imdb& db)
+{
+  int forwardIndex = 0, backwardIndex = 0;
+  while (forward[forwardIndex].actor != meetRecord) forwardIndex++;
+  while (backward[backwardIndex].actor != meetRecord) backwardIndex++;
+  path result(db.getActorName(meetRecord));
+  appendRecordChain(result, forward, forwardIndex, db);
+  result.reverse();
+  appendRecordChain(result, backward, backwardIndex, db);
+  return result;
+}
+
+/**
+ * The search proper never builds a string; names are looked up only for the
+ * handful of records that make it into the final path.  Shared by
+ * getShortestPathByRecord and getShortestPathFiltered, which differ only
+ * in whether filter is NULL.
+ */
+
+static path searchRecords(const string& startActor, const string& goalActor,
+			  const imdb& db, const movieFilter *filter, searchStats *stats)
+{
+  int startRecord = db.getActorRecord(startActor);
+  int goalRecord = db.getActorRecord(goalActor);
+  if (startRecord == -1 || goalRecord == -1) return path("");
+  if (startRecord == goalRecord) return path(startActor);
+
+  recordSide *forward, *backward;
+  acquireRecordSides(db, startRecord, goalRecord, forward, backward);
+  int meetRecord = -1;
+  while (meetRecord == -1 && forward->frontierSize() > 0 && backward->frontierSize() > 0 &&
+	 forward->depth + backward->depth < maxPathLength) {
+    recordSide& side = forward->frontierSize() <= backward->frontierSize() ? *forward : *backward;
+    int meetIndex = expandRecordLevel(side, &side == forward ? *backward : *forward, db, filter, stats);
+    if (meetIndex != -1) meetRecord = side.nodes[meetIndex].actor;
+  }
+  PROFILE_VISITED(forward->nodes.size() + backward->nodes.size(),
+		  forward->movies.size() + backward->movies.size());
+  if (meetRecord == -1) return path("");
+  PROFILE_STAGE(STAGE_PATH);
+  return joinRecordChains(forward->nodes, backward->nodes, meetRecord, db);
+}
+
+path getShortestPathByRecord(const string& startActor, const string& goalActor,
+			     const imdb& db, searchStats *stats)
+{
+  return searchRecords(startActor, goalActor, db, NULL, stats);
+}
+
+path getShortestPathFiltered(const string& startActor, const string& goalActor,
+			     const imdb& db, const movieFilter& filter, searchStats *stats)
+{
+  return searchRecords(startActor, goalActor, db, &filter, stats);
+}
+
+/**
+ * The parallel counterpart to recordSide.  The visited sets are atomic,
+ * since every worker inserts into them at once while a level is expanded.
+ */
+
+struct parallelSide {
+  atomicRecordSet seenActors;
+  atomicRecordSet seenMovies;
+  vector<recordNode> nodes;
+  size_t levelStart;
+  int depth;
+
+  parallelSide(const imdb& db, int root) :
+    seenActors(db.getFileSize(imdb::ACTOR)), seenMovies(db.getFileSize(imdb::MOVIE)),
+    levelStart(0), depth(0) {
+    seenActors.insert(root);
+    nodes.push_back(recordNode(root, -1, -1));
+  }
+
+  size_t frontierSize() const { return nodes.size() - levelStart; }
+};
+
+/**
+ * Parallel counterpart to expandRecordLevel.  Workers claim the frontier in
+ * chunks of kChunkSize actors, and whichever worker wins the test-and-set on
+ * a newly discovered actor or movie owns it.  Newly discovered actors collect
+ * in per-worker buffers, which are appended to side.nodes once every worker
+ * has finished the level.  As soon as any worker finds a meeting point, the
+ * others stop claiming chunks.
+ *
+ * @param buffers one next-frontier buffer per worker, reused across levels.
+ * @return the actor record at the meeting point, or -1 if the sides haven't met.
+ */
+
+static int expandParallelLevel(parallelSide& side, const parallelSide& other, const imdb& db,
+			       workerPool& pool, vector<vector<recordNode> >& buffers,
+			       searchStats *stats)
+{
+  const size_t kChunkSize = 8;
+  size_t levelEnd = side.nodes.size();
+  atomic<size_t> nextChunk(side.levelStart);
+  atomic<int> meetRecord(-1);
+  vector<searchStats> workerStats(pool.size());
+
+  pool.run([&](int worker) {
+    vector<recordNode>& found = buffers[worker];
+    found.clear();
+    while (meetRecord.load(memory_order_relaxed) == -1) {
+      size_t begin = nextChunk.fetch_add(kChunkSize);
+      if (begin >= levelEnd) return;
+      for (size_t i = begin; i < min(begin + kChunkSize, levelEnd); i++) {
+	offsetArray movies;
+	int numMovies = db.getCreditRecords(side.nodes[i].actor, movies);
+	workerStats[worker].actorsExpanded++;
+	for (int j = 0; j < numMovies; j++) {
+	  if (!side.seenMovies.insert(movies[j])) continue;
+	  offsetArray cast;
+	  int castSize = db.getCastRecords(movies[j], cast);
+	  workerStats[worker].moviesExpanded++;
+	  for (int k = 0; k < castSize; k++) {
+	    if (!side.seenActors.insert(cast[k])) continue;
+	    found.push_back(recordNode(cast[k], movies[j], i));
+	    if (other.seenActors.contains(cast[k])) {
+	      int unmet = -1;
+	      meetRecord.compare_exchange_strong(unmet, cast[k]);
+	      return;
+	    }
+	  }
+	}
+      }
+    }
+  });
+
+  for (int worker = 0; worker < pool.size(); worker++) {
+    side.nodes.insert(side.nodes.end(), buffers[worker].begin(), buffers[worker].end());
+    if (stats != NULL) {
+      stats->actorsExpanded += workerStats[worker].actorsExpanded;
+      stats->moviesExpanded += workerStats[worker].moviesExpanded;
+    }
+  }
+  side.levelStart = levelEnd;
+  side.depth++;
+  return meetRecord;
+}
+
+path getShortestPathParallel(const string& startActor, const string& goalActor,
+			     const imdb& db, workerPool& pool, searchStats *stats)
+{
+  int startRecord = db.getActorRecord(startActor);
+  int goalRecord = db.getActorRecord(goalActor);
+  if (startRecord == -1 || goalRecord == -1) return path("");
+  if (startRecord == goalRecord) return path(startActor);
+
+  parallelSide forward(db, startRecord), backward(db, goalRecord);
+  vector<vector<recordNode> > buffers(pool.size());
+  int meetRecord = -1;
+  while (meetRecord == -1 && forward.frontierSize() > 0 && backward.frontierSize() > 0 &&
+	 forward.depth + backward.depth < maxPathLength) {
+    parallelSide& side = forward.frontierSize() <= backward.frontierSize() ? forward : backward;
+    meetRecord = expandParallelLevel(side, &side == &forward ? backward : forward,
+				     db, pool, buffers, stats);
+  }
+  if (meetRecord == -1) return path("");
+  return joinRecordChains(forward.nodes, backward.nodes, meetRecord, db);
+}
+
+/**
+ * The graph snapshot counterpart to recordSide.  IDs are dense, so the
+ * visited sets are plain bit vectors with one bit per actor or movie.
+ * Like a recordSide, a graphSide is reset and reused from one search to
+ * the next.
+ */
+
+struct graphSide {
+  vector<bool> seenActors;
+  vector<bool> seenMovies;
+  vector<recordNode> nodes;
+  vector<int> movies;
+  size_t levelStart;
+  int depth;
+
+  graphSide(const imdbGraph& graph) :
+    seenActors(graph.getNumActors()), seenMovies(graph.getNumMovies()), levelStart(0), depth(0) {}
+
+  bool fits(const imdbGraph& graph) const {
+    return seenActors.size() == (size_t) graph.getNumActors() &&
+      seenMovies.size() == (size_t) graph.getNumMovies();
+  }
+
+  void reset(int root) {
+    for (size_t i = 0; i < nodes.size(); i++) seenActors[nodes[i].actor] = false;
+    for (size_t i = 0; i < movies.size(); i++) seenMovies[movies[i]] = false;
+    nodes.clear();
+    movies.clear();
+    levelStart = 0;
+    depth = 0;
+    seenActors[root] = true;
+    nodes.push_back(recordNode(root, -1, -1));
+  }
+
+  size_t frontierSize() const { return nodes.size() - levelStart; }
+};
+
+/**
+ * Graph snapshot counterpart to acquireRecordSides, shared by the graph and
+ * co-star engines.
+ */
+
+static void acquireGraphSides(const imdbGraph& graph, int start, int goal,
+			      graphSide *& forward, graphSide *& backward)
+{
+  static thread_local unique_ptr<graphSide> sides[2];
+  for (int i = 0; i < 2; i++)
+    if (!sides[i] || !sides[i]->fits(graph)) sides[i].reset(new graphSide(graph));
+  forward = sides[0].get();
+  backward = sides[1].get();
+  forward->reset(start);
+  backward->reset(goal);
+}
+
+/**
+ * Graph snapshot counterpart to expandRecordLevel.  Credits and casts are
+ * contiguous runs of IDs, so expanding an actor is a sequential scan.
+ *
+ * @return the ID of the actor at the meeting point, or -1 if the sides haven't met.
+ */
+
+static int expandGraphLevel(graphSide& side, const graphSide& other,
+			    const imdbGraph& graph, searchStats *stats)
+{
+  PROFILE_STAGE(STAGE_EXPAND);
+  PROFILE_FRONTIER(side.frontierSize());
+  size_t levelEnd = side.nodes.size();
+  for (size_t i = side.levelStart; i < levelEnd; i++) {
+    const int *movies;
+    int numMovies = graph.getCredits(side.nodes[i].actor, movies);
+    if (stats != NULL) stats->actorsExpanded++;
+    PROFILE_COUNT(PROFILE_ACTORS_EXPANDED);
+    PROFILE_ADD(PROFILE_VISITED_INSERTS, numMovies);
+    for (int j = 0; j < numMovies; j++) {
+      if (side.seenMovies[movies[j]]) continue;
+      side.seenMovies[movies[j]] = true;
+      side.movies.push_back(movies[j]);
+      const int *cast;
+      int castSize = graph.getCast(movies[j], cast);
+      if (stats != NULL) stats->moviesExpanded++;
+      PROFILE_COUNT(PROFILE_MOVIES_EXPANDED);
+      PROFILE_ADD(PROFILE_VISITED_INSERTS, castSize);
+      for (int k = 0; k < castSize; k++) {
+	if (side.seenActors[cast[k]]) continue;
+	side.seenActors[cast[k]] = true;
+	side.nodes.push_back(recordNode(cast[k], movies[j], i));
+	if (other.seenActors[cast[k]]) return cast[k];
+      }
+    }
+  }
+  side.levelStart = levelEnd;
+  side.depth++;
+  return -1;
+}
+
+/**
+ * Graph snapshot counterpart to appendRecordChain.
+ */
+
+static void appendGraphChain(path& result, const vector<recordNode>& nodes,
+			     int actor, const imdbGraph& graph)
+{
+  int index = 0;
+  while (nodes[index].actor != actor) index++;
+  for (; nodes[index].parent != -1; index = nodes[index].parent) {
+    film movie;
+    movie.title = graph.getMovieTitle(nodes[index].movie);
+    movie.year = graph.getMovieYear(nodes[index].movie);
+    result.addConnection(movie, graph.getActorName(nodes[nodes[index].parent].actor));
+  }
+}
+
+path getShortestPathOnGraph(const string& startActor, const string& goalActor,
+			    const imdb& db, searchStats *stats)
+{
+  const imdbGraph *graph = db.getGraph();
+  if (graph == NULL) return getShortestPathByRecord(startActor, goalActor, db, stats);
+  int start = graph->findActor(startActor);
+  int goal = graph->findActor(goalActor);
+  if (start == -1 || goal == -1) return path("");
+  if (start == goal) return path(startActor);
+
+  graphSide *forward, *backward;
+  acquireGraphSides(*graph, start, goal, forward, backward);
+  int meet = -1;
+  while (meet == -1 && forward->frontierSize() > 0 && backward->frontierSize() > 0 &&
+	 forward->depth + backward->depth < maxPathLength) {
+    graphSide& side = forward->frontierSize() <= backward->frontierSize() ? *forward : *backward;
+    meet = expandGraphLevel(side, &side == forward ? *backward : *forward, *graph, stats);
+  }
+  PROFILE_VISITED(forward->nodes.size() + backward->nodes.size(),
+		  forward->movies.size() + backward->movies.size());
+  if (meet == -1) return path("");
+
+  PROFILE_STAGE(STAGE_PATH);
+  path result(graph->getActorName(meet));
+  appendGraphChain(result, forward->nodes, meet, *graph);
+  result.reverse();
+  appendGraphChain(result, backward->nodes, meet, *graph);
+  return result;
+}
+
+/**
+ * Co-star counterpart to expandGraphLevel.  Each level is a single hop
+ * from actor straight to co-star, and the node records the witness movie
+ * where expandGraphLevel would record the movie whose cast it expanded.
+ *
+ * @return the ID of the actor at the meeting point, or -1 if the sides haven't met.
+ */
+
+static int expandCostarLevel(graphSide& side, const graphSide& other,
+			     const costarGraph& costars, searchStats *stats)
+{
+  PROFILE_STAGE(STAGE_EXPAND);
+  PROFILE_FRONTIER(side.frontierSize());
+  size_t levelEnd = side.nodes.size();
+  for (size_t i = side.levelStart; i < levelEnd; i++) {
+    const int *ids, *witnesses;
+    int numCostars = costars.getCostars(side.nodes[i].actor, ids, witnesses);
+    if (stats != NULL) stats->actorsExpanded++;
+    PROFILE_COUNT(PROFILE_ACTORS_EXPANDED);
+    PROFILE_ADD(PROFILE_VISITED_INSERTS, numCostars);
+    for (int k = 0; k < numCostars; k++) {
+      if (side.seenActors[ids[k]]) continue;
+      side.seenActors[ids[k]] = true;
+      side.nodes.push_back(recordNode(ids[k], witnesses[k], i));
+      if (other.seenActors[ids[k]]) return ids[k];
+    }
+  }
+  side.levelStart = levelEnd;
+  side.depth++;
+  return -1;
+}
+
+path getShortestPathOnCostars(const string& startActor, const string& goalActor,
+			      const imdb& db, searchStats *stats)
+{
+  const imdbGraph *graph = db.getGraph();
+  const costarGraph *costars = db.getCostarGraph();
+  if (costars == NULL) return getShortestPathOnGraph(startActor, goalActor, db, stats);
+  int start = graph->findActor(startActor);
+  int goal = graph->findActor(goalActor);
+  if (start == -1 || goal == -1) return path("");
+  if (start == goal) return path(startActor);
+
+  graphSide *forward, *backward;
+  acquireGraphSides(*graph, start, goal, forward, backward);
+  int meet = -1;
+  while (meet == -1 && forward->frontierSize() > 0 && backward->frontierSize() > 0 &&
+	 forward->depth + backward->depth < maxPathLength) {
+    graphSide& side = forward->frontierSize() <= backward->frontierSize() ? *forward : *backward;
+    meet = expandCostarLevel(side, &side == forward ? *backward : *forward, *costars, stats);
+  }
+  PROFILE_VISITED(forward->nodes.size() + backward->nodes.size(),
+		  forward->movies.size() + backward->movies.size());
+  if (meet == -1) return path("");
+
+  PROFILE_STAGE(STAGE_PATH);
+  path result(graph->getActorName(meet));
+  appendGraphChain(result, forward->nodes, meet, *graph);
+  result.reverse();
+  appendGraphChain(result, backward->nodes, meet, *graph);
+  return result;
+}
+
+/**
+ * The queue holds every actor reached so far, in the order each was reached,
+ * so the actors at the current distance are simply the run between levelStart
+ * and levelEnd.  Nothing else is allocated per actor.
+ */
+
+long sweepDistances(const string& sourceActor, const imdb& db, vector<long>& histogram,
+		    ostream *perActor, searchStats *stats, const movieFilter *filter)
+{
+  histogram.clear();
+  int sourceRecord = db.getActorRecord(sourceActor);
+  if (sourceRecord == -1) return -1;
+
+  recordSet seenActors(db.getFileSize(imdb::ACTOR)), seenMovies(db.getFileSize(imdb::MOVIE));
+  vector<int> queue(1, sourceRecord);
+  seenActors.insert(sourceRecord);
+  if (perActor != NULL) *perActor << 0 << '\t' << sourceActor << '\n';
+  for (size_t levelStart = 0; levelStart < queue.size(); ) {
+    size_t levelEnd = queue.size();
+    int distance = histogram.size();
+    histogram.push_back(levelEnd - levelStart);
+    for (size_t i = levelStart; i < levelEnd; i++) {
+      offsetArray movies;
+      int numMovies = db.getCreditRecords(queue[i], movies);
+      if (stats != NULL) stats->actorsExpanded++;
+      for (int j = 0; j < numMovies; j++) {
+	if (!seenMovies.insert(movies[j])) continue;
+	if (filter != NULL && !filter->allows(movies[j])) continue;
+	offsetArray cast;
+	int castSize = db.getCastRecords(movies[j], cast);
+	if (stats != NULL) stats->moviesExpanded++;
+	for (int k = 0; k < castSize; k++) {
+	  if (!seenActors.insert(cast[k])) continue;
+	  queue.push_back(cast[k]);
+	  if (perActor != NULL) *perActor << distance + 1 << '\t' << db.getActorName(cast[k]) << '\n';
+	}
+      }
+    }
+    levelStart = levelEnd;
+  }
+  return queue.size();
+}
+
+void getDegreeHistogram(const imdb& db, vector<long>& histogram)
+{
+  histogram.clear();
+  for (int i = 0; i < db.getNumActors(); i++) {
+    offsetArray movies;
+    size_t numMovies = db.getCreditRecords(db.getActorRecordAt(i), movies);
+    if (numMovies >= histogram.size()) histogram.resize(numMovies + 1);
+    histogram[numMovies]++;
+  }
+}
+
+/**
+ * The "parallel" entry in kSearchEngines runs on one shared pool with a
+ * worker per hardware thread.  A pool runs one task at a time, so
+ * concurrent callers take turns.
+ */
+
+static path getShortestPathParallelShared(const string& startActor, const string& goalActor,
+					  const imdb& db, searchStats *stats)
+{
+  static workerPool pool(thread::hardware_concurrency());
+  static mutex poolLock;
+  lock_guard<mutex> guard(poolLock);
+  return getShortestPathParallel(startActor, goalActor, db, pool, stats);
+}
+
+const searchEngineEntry kSearchEngines[] = {
+  { "bfs", getShortestPath },
+  { "bidirectional", getShortestPathBidirectional },
+  { "records", getShortestPathByRecord },
+  { "parallel", getShortestPathParallelShared },
+  { "graph", getShortestPathOnGraph },
+  { "costars", getShortestPathOnCostars }
+};
+
+const int kNumSearchEngines = sizeof(kSearchEngines) / sizeof(kSearchEngines[0]);
+
+searchEngine lookupSearchEngine(const string& name)
+{
+  for (int i = 0; i < kNumSearchEngines; i++)
+    if (name == kSearchEngines[i].name) return kSearchEngines[i].search;
+  return NULL;
+}
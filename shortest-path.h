@@ -0,0 +1,218 @@
+#ifndef __shortest_path__
+#define __shortest_path__
+
+#include "imdb.h"
+#include "path.h"
+#include "worker-pool.h"
+#include "movie-filter.h"
+#include <string>
+#include <vector>
+#include <ostream>
+using namespace std;
+
+/**
+ * Constant: kDefaultMaxPathLength
+ * -------------------------------
+ * The longest path (measured in movies) that any of the search
+ * engines will consider before giving up, unless told otherwise
+ * through setMaxPathLength.
+ */
+
+static const int kDefaultMaxPathLength = 6;
+
+/**
+ * Functions: setMaxPathLength
+ *            getMaxPathLength
+ * ---------------------------
+ * Set and report the longest path (in movies) every search engine will
+ * consider, kDefaultMaxPathLength to begin with.  Obscure actors can sit
+ * seven or more movies apart.  The limit is shared by every thread, so
+ * it should be set before any searches start.
+ */
+
+void setMaxPathLength(int length);
+int getMaxPathLength();
+
+/**
+ * Convenience struct: searchStats
+ * -------------------------------
+ * Counters a search engine updates as it runs, so that clients
+ * (typically benchmarks) can compare how much work two engines
+ * did to answer the same query.  All counters are added to, not
+ * reset, so one searchStats can accumulate over many queries.
+ */
+
+struct searchStats {
+  long actorsExpanded; /// number of actors whose credits were fetched
+  long moviesExpanded; /// number of movies whose casts were fetched
+
+  searchStats() : actorsExpanded(0), moviesExpanded(0) {}
+};
+
+/**
+ * Function: getShortestPath
+ * -------------------------
+ * Runs a one-sided breadth-first search from startActor, and returns
+ * the shortest path connecting startActor to goalActor.  If no such
+ * path of length getMaxPathLength() or less exists, then the empty
+ * path with an empty start player is returned.
+ *
+ * @param startActor the actor/actress the path should start with.
+ * @param goalActor the actor/actress the path should end with.
+ * @param db the imdb consulted for credits and casts.
+ * @param stats if non-NULL, updated with the amount of work done.
+ * @return the shortest path from startActor to goalActor, or path("").
+ */
+
+path getShortestPath(const string& startActor, const string& goalActor,
+		     const imdb& db, searchStats *stats = NULL);
+
+/**
+ * Function: getShortestPathBidirectional
+ * --------------------------------------
+ * Same contract as getShortestPath, but grows a breadth-first frontier
+ * from both actors at once, always expanding whichever frontier is
+ * smaller.  The two halves are joined where they meet.  For long paths
+ * this touches a small fraction of the actors the one-sided search does.
+ */
+
+path getShortestPathBidirectional(const string& startActor, const string& goalActor,
+				  const imdb& db, searchStats *stats = NULL);
+
+/**
+ * Function: getShortestPathByRecord
+ * ---------------------------------
+ * Same contract as getShortestPathBidirectional, but the search runs entirely
+ * on record offsets (see imdb::getActorRecord and friends), with visited
+ * actors and movies tracked in flat bitsets.  No strings are built and no
+ * tree nodes are allocated until the final path is assembled.
+ */
+
+path getShortestPathByRecord(const string& startActor, const string& goalActor,
+			     const imdb& db, searchStats *stats = NULL);
+
+/**
+ * Function: getShortestPathFiltered
+ * ---------------------------------
+ * Same contract as getShortestPathByRecord, but the path may only pass
+ * through movies the specified filter allows (see movie-filter.h), such as
+ * those made before 1970.  Rejected movies are pruned as they're reached,
+ * before their casts are fetched, so a narrow filter makes the search
+ * cheaper rather than dearer.
+ */
+
+path getShortestPathFiltered(const string& startActor, const string& goalActor,
+			     const imdb& db, const movieFilter& filter, searchStats *stats = NULL);
+
+/**
+ * Function: getShortestPathParallel
+ * ---------------------------------
+ * Same contract as getShortestPathByRecord, but each level of the search is
+ * split across the workers of the specified pool, so the number of threads
+ * is the size of the pool.  Visited actors and movies are claimed with an
+ * atomic test-and-set, and each worker collects the actors it discovers in
+ * its own buffer; the buffers are merged once the whole level is done.
+ */
+
+path getShortestPathParallel(const string& startActor, const string& goalActor,
+			     const imdb& db, workerPool& pool, searchStats *stats = NULL);
+
+/**
+ * Function: getShortestPathOnGraph
+ * --------------------------------
+ * Same contract as getShortestPathByRecord, but the search runs on the
+ * compressed-sparse-row snapshot returned by db.getGraph() (see build-graph),
+ * using dense IDs and contiguous neighbour arrays.  If the imdb has no graph
+ * snapshot loaded, this falls back on getShortestPathByRecord.
+ */
+
+path getShortestPathOnGraph(const string& startActor, const string& goalActor,
+			    const imdb& db, searchStats *stats = NULL);
+
+/**
+ * Function: getShortestPathOnCostars
+ * ----------------------------------
+ * Same contract as getShortestPathOnGraph, but the search runs on the
+ * precomputed co-star adjacency returned by db.getCostarGraph() (see
+ * build-graph --costars), so each level is a single actor-to-co-star hop
+ * and no casts are expanded.  Falls back on getShortestPathOnGraph if the
+ * imdb has no co-star adjacency loaded.
+ */
+
+path getShortestPathOnCostars(const string& startActor, const string& goalActor,
+			      const imdb& db, searchStats *stats = NULL);
+
+/**
+ * Function: sweepDistances
+ * ------------------------
+ * Runs one full breadth-first search from sourceActor over every actor
+ * reachable from it, with no limit on depth, and counts how many actors
+ * sit at each distance (in movies).  The search runs on record offsets,
+ * like getShortestPathByRecord, and touches each actor and movie once,
+ * so a whole table of distances costs a single linear pass rather than
+ * one search per target.
+ *
+ * @param sourceActor the actor/actress every distance is measured from.
+ * @param db the imdb consulted for credits and casts.
+ * @param histogram cleared, then histogram[d] set to the number of actors at
+ *                  distance d (histogram[0] is 1, for sourceActor itself).
+ * @param perActor if non-NULL, each actor reached is written to it as soon
+ *                 as it's discovered, one "distance<tab>name" line apiece,
+ *                 in order of increasing distance.
+ * @param stats if non-NULL, updated with the amount of work done.
+ * @param filter if non-NULL, the movies the search may pass through (see
+ *               getShortestPathFiltered); actors only reachable through
+ *               other movies go uncounted.
+ * @return the number of actors reached, or -1 if sourceActor isn't in the database.
+ */
+
+long sweepDistances(const string& sourceActor, const imdb& db, vector<long>& histogram,
+		    ostream *perActor = NULL, searchStats *stats = NULL,
+		    const movieFilter *filter = NULL);
+
+/**
+ * Function: getDegreeHistogram
+ * ----------------------------
+ * Walks every actor record once and sets histogram[n] to the number of
+ * actors credited in exactly n movies.
+ */
+
+void getDegreeHistogram(const imdb& db, vector<long>& histogram);
+
+/**
+ * Type: searchEngine
+ * ------------------
+ * The signature shared by all of the search functions above, so that
+ * clients can choose an engine by name at runtime.
+ */
+
+typedef path (*searchEngine)(const string& startActor, const string& goalActor,
+			     const imdb& db, searchStats *stats);
+
+struct searchEngineEntry {
+  const char *name;
+  searchEngine search;
+};
+
+/**
+ * Constants: kSearchEngines
+ *            kNumSearchEngines
+ * ----------------------------
+ * Every available search engine, listed under the name clients use
+ * to select it ("bfs", "bidirectional", "records", "parallel", "graph", "costars").  The
+ * "parallel" engine uses one worker per hardware thread.
+ */
+
+extern const searchEngineEntry kSearchEngines[];
+extern const int kNumSearchEngines;
+
+/**
+ * Function: lookupSearchEngine
+ * ----------------------------
+ * Returns the engine listed in kSearchEngines under the specified
+ * name, or NULL if there isn't one.
+ */
+
+searchEngine lookupSearchEngine(const string& name);
+
+#endif
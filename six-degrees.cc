@@ -1,20 +1,50 @@
 #include <vector>
-#include <list>
-#include <set>
 #include <string>
 #include <iostream>
 #include <iomanip>
 #include <cstdlib>
+#include <fstream>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <memory>
 #include "imdb.h"
+#include "cached_imdb.h"
 #include "path.h"
+#include "shortest-path.h"
+#include "worker-pool.h"
+#include "query-server.h"
+#include "query-profile.h"
 using namespace std;
 
+/**
+ * Lists up to kNumSuggestions actors whose names the specified response
+ * might have meant: those with a word beginning with it, or failing that,
+ * those spelled most like it.  Prints nothing if no suggestion index was
+ * built (see build-index).
+ */
+
+static void suggestActors(const string& response, const imdb& db)
+{
+  const int kNumSuggestions = 5;
+  const suggestIndex *index = db.getSuggestIndex();
+  if (index == NULL) return;
+  vector<int> records;
+  if (index->suggestByPrefix(response, kNumSuggestions, records) == 0)
+    index->suggestSimilar(response, kNumSuggestions, records);
+  if (records.empty()) return;
+  cout << "Did you mean:" << endl;
+  for (size_t i = 0; i < records.size(); i++)
+    cout << "    " << db.getActorName(records[i]) << endl;
+}
+
 /**
  * Using the specified prompt, requests that the user supply
  * the name of an actor or actress.  The code returns
  * once the user has supplied a name for which some record within
  * the referenced imdb existsif (or if the user just hits return,
  * which is a signal that the empty string should just be returned.)
+ * Names that don't match exactly are answered with suggestions.
  *
  * @param prompt the text that should be used for the meaningful
  *               part of the user prompt.
@@ -31,25 +61,263 @@ static string promptForActor(const string& prompt, const imdb& db)
     cout << prompt << " [or <enter> to quit]: ";
     getline(cin, response);
     if (response == "") return "";
-    vector<film> credits;
+    creditList credits;
     if (db.getCredits(response, credits)) return response;
     cout << "We couldn't find \"" << response << "\" in the movie database. "
 	 << "Please try again." << endl;
+    suggestActors(response, db);
   }
 }
 
+/**
+ * Convenience struct holding the outcome of one batch query: whether
+ * both actors were in the database, the length of the shortest path
+ * (-1 if there was none), the path itself (path("") if there was none,
+ * or if only the length was asked for), and how long the query took.
+ */
+
+struct batchResult {
+  bool found;
+  int length;
+  path route;
+  double seconds;
+  string profile;  // the query's profile as JSON, if profiling is on
+
+  batchResult() : found(false), length(-1), route(""), seconds(0) {}
+};
+
+/**
+ * Formats the specified path as a JSON array alternating between
+ * player names and {"title": ..., "year": ...} movie objects.
+ */
+
+static string pathAsJson(const path& p)
+{
+  string json = "[" + jsonQuote(p.getPlayer(0));
+  for (int i = 0; i < p.getLength(); i++) {
+    const film& movie = p.getMovie(i);
+    json += ", {\"title\": " + jsonQuote(movie.title) + ", \"year\": " + to_string(movie.year) + "}";
+    json += ", " + jsonQuote(p.getPlayer(i + 1));
+  }
+  return json + "]";
+}
+
+/**
+ * Answers every query in a file of actor pairs (one pair per line, the two
+ * names separated by a tab) without any prompting.  The queries are spread
+ * over a pool of worker threads that all share the one imdb, which is safe
+ * because the mapped data is never written.  Results are written in input
+ * order as JSON lines, one object per query:
+ *
+ *     {"source": ..., "target": ..., "found": true, "length": 3, "ms": 0.42, "path": [...]}
+ *
+ * where length and path are null if no path exists, and found is false if
+ * either actor is missing from the database.  Throughput and p50/p99
+ * latency are reported on cerr.
+ *
+ * When only distances are wanted and a distance oracle (see build-labels)
+ * was loaded, each length comes straight from the oracle, no search is
+ * run, and path is always null.  Without an oracle, the search answers
+ * as usual and only its length is reported.  If filter isn't NULL, every
+ * query is answered by getShortestPathFiltered instead of search, and the
+ * oracle (which knows nothing of the filter) is never consulted.
+ *
+ * With profiling on (see query-profile.h), each line also carries a
+ * "profile" object for its query, and the aggregate over every query is
+ * written to cerr at the end as one more JSON line.
+ *
+ * @param db the imdb being queried.
+ * @param search the search engine answering the queries.
+ * @param pairsFile the name of the file of actor pairs.
+ * @param outputFile the name of the file results are written to, or NULL for cout.
+ * @param numWorkers the number of threads answering queries.
+ * @param distanceOnly true if only the lengths of the paths are wanted.
+ * @param filter the movies paths may pass through, or NULL for all of them.
+ * @return the program's exit status.
+ */
+
+static int runBatch(const imdb& db, searchEngine search, const char *pairsFile,
+		    const char *outputFile, int numWorkers, bool distanceOnly,
+		    const movieFilter *filter)
+{
+  vector<pair<string, string> > pairs;
+  if (!readActorPairs(pairsFile, pairs)) {
+    cerr << "Couldn't open \"" << pairsFile << "\"." << endl;
+    return 1;
+  }
+  ofstream file;
+  if (outputFile != NULL) {
+    file.open(outputFile);
+    if (!file) { cerr << "Couldn't write \"" << outputFile << "\"." << endl; return 1; }
+  }
+  ostream& out = outputFile != NULL ? file : cout;
+
+  vector<batchResult> results(pairs.size());
+  const distanceOracle *oracle = distanceOnly && filter == NULL ? db.getDistanceOracle() : NULL;
+  atomic<size_t> nextQuery(0);
+  workerPool pool(numWorkers);
+  double start = monotonicSeconds();
+  pool.run([&](int worker) {
+    for (size_t i = nextQuery++; i < pairs.size(); i = nextQuery++) {
+      if (isProfiling()) beginQueryProfile();
+      double queryStart = monotonicSeconds();
+      batchResult& result = results[i];
+      if (oracle != NULL) {
+	int source = db.getGraph()->findActor(pairs[i].first);
+	int target = db.getGraph()->findActor(pairs[i].second);
+	result.found = source != -1 && target != -1;
+	if (result.found) result.length = oracle->getDistance(source, target);
+	if (result.length > getMaxPathLength()) result.length = -1;  // as a search would find no path
+      } else {
+	result.found = db.getActorRecord(pairs[i].first) != -1 &&
+	  db.getActorRecord(pairs[i].second) != -1;
+	if (result.found)
+	  result.route = filter != NULL ?
+	    getShortestPathFiltered(pairs[i].first, pairs[i].second, db, *filter, NULL) :
+	    search(pairs[i].first, pairs[i].second, db, NULL);
+	if (result.route.getLastPlayer() != "") result.length = result.route.getLength();
+	if (distanceOnly) result.route = path("");
+      }
+      result.seconds = monotonicSeconds() - queryStart;
+      if (isProfiling()) {
+	endQueryProfile();
+	result.profile = profileAsJson(currentProfile());
+      }
+    }
+  });
+  double elapsed = monotonicSeconds() - start;
+
+  vector<double> latencies;
+  for (size_t i = 0; i < pairs.size(); i++) {
+    const batchResult& result = results[i];
+    bool hasPath = result.route.getLastPlayer() != "";
+    out << "{\"source\": " << jsonQuote(pairs[i].first)
+	<< ", \"target\": " << jsonQuote(pairs[i].second)
+	<< ", \"found\": " << (result.found ? "true" : "false")
+	<< ", \"length\": " << (result.length != -1 ? to_string(result.length) : "null")
+	<< ", \"ms\": " << result.seconds * 1000
+	<< ", \"path\": " << (hasPath ? pathAsJson(result.route) : "null");
+    if (isProfiling()) out << ", \"profile\": " << result.profile;
+    out << "}" << endl;
+    latencies.push_back(result.seconds);
+  }
+
+  sort(latencies.begin(), latencies.end());
+  double p50 = latencies.empty() ? 0 : latencies[(latencies.size() - 1) / 2];
+  double p99 = latencies.empty() ? 0 : latencies[(latencies.size() - 1) * 99 / 100];
+  cerr << "Answered " << pairs.size() << (oracle != NULL ? " distance" : "") << " queries on "
+       << pool.size() << " workers in "
+       << elapsed << " s (" << (elapsed > 0 ? pairs.size() / elapsed : 0) << " queries/sec); "
+       << "p50 " << p50 * 1000 << " ms, p99 " << p99 * 1000 << " ms." << endl;
+  if (isProfiling()) cerr << aggregateProfileAsJson() << endl;
+  return 0;
+}
+
+/**
+ * Function: runSweep
+ * ------------------
+ * Measures the distance from sourceActor to every actor in the database
+ * with a single full search (see sweepDistances), and prints a histogram
+ * of the distances found, followed by the distribution of credits per actor
+ * over the whole database.  If outputFile isn't NULL, every reached actor's
+ * distance is streamed to it while the search runs.  If filter isn't NULL,
+ * the search only passes through the movies it allows.
+ *
+ * @return the program's exit status.
+ */
+
+static int runSweep(const imdb& db, const string& sourceActor, const char *outputFile,
+		    const movieFilter *filter)
+{
+  ofstream file;
+  if (outputFile != NULL) {
+    file.open(outputFile);
+    if (!file) {
+      cerr << "Couldn't write to \"" << outputFile << "\"." << endl;
+      return 1;
+    }
+  }
+
+  vector<long> distances;
+  searchStats stats;
+  double start = monotonicSeconds();
+  long reached = sweepDistances(sourceActor, db, distances, outputFile != NULL ? &file : NULL, &stats, filter);
+  double elapsed = monotonicSeconds() - start;
+  if (reached == -1) {
+    cerr << "We couldn't find \"" << sourceActor << "\" in the movie database." << endl;
+    return 1;
+  }
+
+  cout << "Distances from " << sourceActor << ":" << endl;
+  for (size_t d = 0; d < distances.size(); d++)
+    cout << setw(6) << d << setw(12) << distances[d] << endl;
+  cout << setw(6) << "none" << setw(12) << db.getNumActors() - reached << endl;
+  cout << "Reached " << reached << " of " << db.getNumActors() << " actors through "
+       << stats.moviesExpanded << " movies in " << elapsed << " s." << endl << endl;
+
+  vector<long> degrees;
+  getDegreeHistogram(db, degrees);
+  cout << "Movies per actor:" << endl;
+  for (size_t n = 0; n < degrees.size(); n++)
+    if (degrees[n] > 0) cout << setw(6) << n << setw(12) << degrees[n] << endl;
+  return 0;
+}
+
+/**
+ * Converts a comma-separated list of mapping options ("prefault", "lock",
+ * and "huge") into the flags imdb's constructor expects.  Unknown options
+ * end the program.
+ */
+
+static int parseMapOptions(const string& list)
+{
+  int options = 0;
+  for (size_t start = 0; start <= list.size(); ) {
+    size_t end = list.find(',', start);
+    if (end == string::npos) end = list.size();
+    string option = list.substr(start, end - start);
+    if (option == "prefault") options |= imdb::PREFAULT;
+    else if (option == "lock") options |= imdb::LOCK_PAGES;
+    else if (option == "huge") options |= imdb::HUGE_PAGES;
+    else {
+      cout << "Unknown mapping option \"" << option << "\"." << endl;
+      exit(1);
+    }
+    start = end + 1;
+  }
+  return options;
+}
+
 /**
  * Serves as the main entry point for the six-degrees executable.
- * There are no parameters to speak of.
+ *
+ * Usage: six-degrees [--engine=bfs|bidirectional|records|parallel|graph|costars] [--cache=MB]
+ *                    [--batch=pairs-file [--workers=N] [--output=file] [--distance-only]]
+ *                    [--from=actor [--output=file]] [--max-depth=N] [--years=FIRST-LAST]
+ *                    [--serve=socket-path [--workers=N]] [--profile]
+ *                    [--map=prefault,lock,huge] [data-directory]
  *
  * @param argc the number of tokens passed to the command line to
- *             invoke this executable.  It's completely ignored
- *             here, because we don't expect any arguments.
+ *             invoke this executable.
  * @param argv the C strings making up the full command line.
  *             We expect argv[0] to be logically equivalent to
  *             "six-degrees" (or whatever absolute path was used to
- *             invoke the program), but otherwise these are ignored
- *             as well.
+ *             invoke the program).  --engine selects the search engine
+ *             (bidirectional by default), --cache puts a cached_imdb with
+ *             the specified budget in front of the data files, --batch
+ *             answers a file of queries non-interactively (see runBatch),
+ *             --distance-only has it report lengths alone, --from reports
+ *             the distance from one actor to everyone else (see runSweep),
+ *             --max-depth raises or lowers the longest path searched for
+ *             (see setMaxPathLength), --years allows only paths through
+ *             movies made in that range (see getShortestPathFiltered;
+ *             either end may be left open), for --from as much as for
+ *             any other query, --serve keeps the imdb loaded and
+ *             answers queries over a Unix domain socket until interrupted
+ *             (see query-server.h, query-client, and query-load), --profile
+ *             reports counters and stage times for every search as JSON (in
+ *             a build made with PROFILE=1; see query-profile.h), --map chooses how the data files
+ *             are mapped (see imdb's constructor), and any other argument names the directory holding the data files.
  * @return 0 if the program ends normally, and undefined otherwise.
  */
 
@@ -58,55 +326,100 @@ void printPath(path& p){
 
 }
 
-path getShortestPath(const string& startActor, const string& goalActor, imdb& db){
-  list<path> partialPaths = list<path>();
-  set<string> previouslySeenActors = set<string>();
-  set<film> previouslySeenFilms = set<film>();
-  path initialPath = path(startActor);
-  partialPaths.push_back(initialPath);
-  while(!partialPaths.empty() && partialPaths.front().getLength() <= 5) { //this should be checked
-    path thisPath = partialPaths.front();
-    partialPaths.pop_front();
-    string thisActor = thisPath.getLastPlayer();
-    vector<film> thisActorMovies = vector<film>();
-    db.getCredits(thisActor, thisActorMovies);
-    //need to do a check here to make sure that the start actor was foudn
-    for(unsigned int i = 0; i < thisActorMovies.size(); i++){
-      film currMovie = thisActorMovies[i];
-      if (previouslySeenFilms.insert(currMovie).second){
-	vector<string> otherActors = vector<string>();
-	db.getCast(currMovie, otherActors);
-	//need to do a check to make sure that the other movies work
-	for(unsigned int j= 0; j < otherActors.size(); j++){
-	  string otherActor = otherActors[j];
-	  if(previouslySeenActors.insert(otherActor).second){
-	    path newPath = thisPath; //not sure what type of copy to do here
-	    newPath.addConnection(currMovie, otherActor);
-	    if(otherActor == goalActor) { //not sure we can do equals here
-	      return newPath;
-	    } else {
-	      partialPaths.push_back(newPath);
-	    }
-
-	  }
-	}
+int main(int argc, const char *argv[])
+{
+  const char *dataDirectory = NULL;
+  searchEngine search = getShortestPathBidirectional;
+  size_t cacheMegabytes = 0;
+  const char *batchFile = NULL;
+  const char *sweepSource = NULL;
+  const char *socketPath = NULL;
+  const char *outputFile = NULL;
+  int numWorkers = thread::hardware_concurrency();
+  bool distanceOnly = false;
+  int mapOptions = 0;
+  const char *yearRange = NULL;
+  int firstYear, lastYear;
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg.compare(0, 8, "--batch=") == 0) {
+      batchFile = argv[i] + 8;
+    } else if (arg.compare(0, 8, "--serve=") == 0) {
+      socketPath = argv[i] + 8;
+    } else if (arg.compare(0, 7, "--from=") == 0) {
+      sweepSource = argv[i] + 7;
+    } else if (arg.compare(0, 9, "--output=") == 0) {
+      outputFile = argv[i] + 9;
+    } else if (arg.compare(0, 10, "--workers=") == 0) {
+      numWorkers = atoi(argv[i] + 10);
+    } else if (arg == "--profile") {
+      if (!setProfiling(true))
+	cerr << "Profiling isn't compiled in; rebuild with make clean; make PROFILE=1." << endl;
+    } else if (arg == "--distance-only") {
+      distanceOnly = true;
+    } else if (arg.compare(0, 12, "--max-depth=") == 0) {
+      setMaxPathLength(atoi(argv[i] + 12));
+    } else if (arg.compare(0, 8, "--years=") == 0) {
+      yearRange = argv[i] + 8;
+      if (!parseYearRange(yearRange, firstYear, lastYear)) {
+	cout << "Bad year range \"" << yearRange << "\"." << endl;
+	exit(1);
       }
-    }
+    } else if (arg.compare(0, 6, "--map=") == 0) {
+      mapOptions = parseMapOptions(arg.substr(6));
+    } else if (arg.compare(0, 8, "--cache=") == 0) {
+      cacheMegabytes = atol(arg.c_str() + 8);
+    } else if (arg.compare(0, 9, "--engine=") == 0) {
+      search = lookupSearchEngine(arg.substr(9));
+      if (search == NULL) {
+	cout << "Unknown search engine \"" << arg.substr(9) << "\"." << endl;
+	exit(1);
+      }
+    } else dataDirectory = argv[i];
   }
-  path returnPath = path("");
-  return returnPath;
-}
-
-
 
-int main(int argc, const char *argv[])
-{
-  imdb db(determinePathToData(argv[1])); // inlined in imdb-utils.h
+  const char *directory = determinePathToData(dataDirectory); // inlined in imdb-utils.h
+  imdb *cachedOrPlain;
+  double start = monotonicSeconds();
+  if (cacheMegabytes > 0)
+    cachedOrPlain = new cached_imdb(directory, cacheMegabytes << 20,
+				    cached_imdb::kDefaultNumShards, mapOptions);
+  else cachedOrPlain = new imdb(directory, mapOptions);
+  const imdb& db = *cachedOrPlain;
   if (!db.good()) {
     cout << "Failed to properly initialize the imdb database." << endl;
-    cout << "Please check to make sure the source files exist and that you have permission to read them." << endl;
+    cout << db.getLoadErrorMessage() << endl;
+    if (db.getLoadError() != imdb::MALFORMED_FILE)
+      cout << "Please check to make sure the source files exist and that you have permission to read them." << endl;
     exit(1);
   }
+  if (mapOptions != 0)
+    cerr << "Mapped the data files in " << (monotonicSeconds() - start) * 1000 << " ms." << endl;
+
+  unique_ptr<yearIndex> years;
+  unique_ptr<movieFilter> filter;
+  if (yearRange != NULL) {
+    years.reset(new yearIndex(db));
+    filter.reset(new movieFilter(*years, firstYear, lastYear));
+  }
+
+  if (sweepSource != NULL) {
+    int status = runSweep(db, sweepSource, outputFile, filter.get());
+    delete cachedOrPlain;
+    return status;
+  }
+
+  if (socketPath != NULL) {
+    int status = queryServer(db, search, filter.get(), numWorkers).serve(socketPath);
+    delete cachedOrPlain;
+    return status;
+  }
+
+  if (batchFile != NULL) {
+    int status = runBatch(db, search, batchFile, outputFile, numWorkers, distanceOnly, filter.get());
+    delete cachedOrPlain;
+    return status;
+  }
   
   while (true) {
     string source = promptForActor("Actor or actress", db);
@@ -116,7 +429,13 @@ int main(int argc, const char *argv[])
     if (source == target) {
       cout << "Good one.  This is only interesting if you specify two different people." << endl;
     } else {
-      path foundPath = getShortestPath(source,target,db);
+      if (isProfiling()) beginQueryProfile();
+      path foundPath = filter ? getShortestPathFiltered(source, target, db, *filter) :
+	search(source, target, db, NULL);
+      if (isProfiling()) {
+	endQueryProfile();
+	cerr << profileAsJson(currentProfile()) << endl;
+      }
       if (foundPath.getLength() == 0 && foundPath.getLastPlayer() == "")
 	cout << endl << "No path between those two people could be found." << endl << endl;
       else cout << foundPath << endl << endl;
@@ -124,6 +443,6 @@ int main(int argc, const char *argv[])
   }
   
   cout << "Thanks for playing!" << endl;
+  delete cachedOrPlain;
   return 0;
 }
-
@@ -0,0 +1,250 @@
+using namespace std;
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include "suggest-index.h"
+#include "imdb.h"
+
+suggestIndex::suggestIndex() :
+  fileMap(NULL), fileSize(0), numActors(0), numWords(0), numTrigrams(0), records(NULL),
+  nameStart(NULL), words(NULL), wordActors(NULL), trigrams(NULL), postingStart(NULL),
+  postings(NULL), pool(NULL) {}
+
+bool suggestIndex::load(const string& fileName, size_t actorFileSize, const dataStamp& stamp)
+{
+  int fd = open(fileName.c_str(), O_RDONLY);
+  if (fd == -1) return false;
+  struct stat stats;
+  if (fstat(fd, &stats) == -1 || stats.st_size < (off_t) (kHeaderInts * sizeof(int))) {
+    close(fd);
+    return false;
+  }
+  void *map = mmap(0, stats.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) return false;
+
+  const int *header = (const int *) map;
+  size_t actors = header[3], wordStarts = header[4], grams = header[5], entries = header[6];
+  size_t poolSize = header[7];
+  size_t expectedSize = (kHeaderInts + 2 * actors + 2 * wordStarts + 2 * grams + 1 + entries) *
+    sizeof(int) + poolSize;
+  if (header[0] != kMagic || header[1] != kVersion || header[2] != (int) actorFileSize ||
+      poolSize % sizeof(int) != 0 || expectedSize != (size_t) stats.st_size ||
+      !stamp.matches(header + kStampAt)) {
+    munmap(map, stats.st_size);
+    return false;
+  }
+
+  fileMap = map;
+  fileSize = stats.st_size;
+  numActors = actors;
+  numWords = wordStarts;
+  numTrigrams = grams;
+  records = header + kHeaderInts;
+  nameStart = records + actors;
+  words = nameStart + actors;
+  wordActors = words + wordStarts;
+  trigrams = wordActors + wordStarts;
+  postingStart = trigrams + grams;
+  postings = postingStart + grams + 1;
+  pool = (const char *) (postings + entries);
+  return true;
+}
+
+/**
+ * Case-folds the specified name the way every name in the pool was folded.
+ */
+
+static string foldName(const char *name)
+{
+  string folded(name);
+  for (size_t i = 0; i < folded.size(); i++)
+    if (folded[i] >= 'A' && folded[i] <= 'Z') folded[i] += 'a' - 'A';
+  return folded;
+}
+
+/**
+ * Fills keys with the distinct trigrams of the specified folded name, padded
+ * with two spaces in front and one behind so that short names and the starts
+ * of names still contribute trigrams.
+ */
+
+static void getTrigrams(const string& folded, vector<int>& keys)
+{
+  string padded = "  " + folded + " ";
+  const unsigned char *bytes = (const unsigned char *) padded.c_str();
+  keys.clear();
+  for (size_t i = 0; i + 3 <= padded.size(); i++)
+    keys.push_back(bytes[i] << 16 | bytes[i + 1] << 8 | bytes[i + 2]);
+  sort(keys.begin(), keys.end());
+  keys.erase(unique(keys.begin(), keys.end()), keys.end());
+}
+
+int suggestIndex::suggestByPrefix(const string& prefix, int limit, vector<int>& found) const
+{
+  found.clear();
+  string key = foldName(prefix.c_str());
+  if (key.empty()) return 0;
+  int low = 0, high = numWords;
+  while (low < high) {
+    int middle = low + (high - low) / 2;
+    if (strcmp(pool + words[middle], key.c_str()) < 0) low = middle + 1;
+    else high = middle;
+  }
+
+  vector<int> actors;
+  for (int i = low; i < numWords && (int) actors.size() < limit &&
+	 strncmp(pool + words[i], key.c_str(), key.size()) == 0; i++)
+    if (find(actors.begin(), actors.end(), wordActors[i]) == actors.end())
+      actors.push_back(wordActors[i]);
+  for (size_t i = 0; i < actors.size(); i++) found.push_back(records[actors[i]]);
+  return found.size();
+}
+
+/**
+ * Candidates are drawn from the posting lists of the query's trigrams, rarest
+ * first, until kCandidateBudget postings have been gathered; common trigrams
+ * (" jo", "an ") would otherwise contribute most of the actors in the database.
+ * Hits are tallied in a per-thread array with one counter per actor, kept from
+ * one query to the next and reset through the list of actors touched, so the
+ * tally is linear in the postings read.  The kVerified actors hit most often
+ * are then scored exactly, by the Dice coefficient of their trigram set and
+ * the query's.
+ */
+
+int suggestIndex::suggestSimilar(const string& name, int limit, vector<int>& found) const
+{
+  const int kCandidateBudget = 20000;
+  const size_t kVerified = 50;
+  found.clear();
+  string folded = foldName(name.c_str());
+  vector<int> query;
+  getTrigrams(folded, query);
+
+  vector<pair<int, int> > lists; // (length, trigram index)
+  for (size_t i = 0; i < query.size(); i++) {
+    const int *match = lower_bound(trigrams, trigrams + numTrigrams, query[i]);
+    if (match == trigrams + numTrigrams || *match != query[i]) continue;
+    int t = match - trigrams;
+    lists.push_back(make_pair(postingStart[t + 1] - postingStart[t], t));
+  }
+  sort(lists.begin(), lists.end());
+
+  static thread_local vector<int> hits;
+  if (hits.size() != (size_t) numActors) hits.assign(numActors, 0);
+  vector<pair<int, int> > touched; // (-hits, actor)
+  int gathered = 0;
+  for (size_t i = 0; i < lists.size(); i++) {
+    int length = lists[i].first;
+    if (gathered > 0 && gathered + length > kCandidateBudget) break;
+    const int *list = postings + postingStart[lists[i].second];
+    for (int j = 0; j < min(length, kCandidateBudget); j++)
+      if (hits[list[j]]++ == 0) touched.push_back(make_pair(0, list[j]));
+    gathered += length;
+  }
+  for (size_t i = 0; i < touched.size(); i++) {
+    touched[i].first = -hits[touched[i].second];
+    hits[touched[i].second] = 0;
+  }
+  size_t verified = min(kVerified, touched.size());
+  partial_sort(touched.begin(), touched.begin() + verified, touched.end());
+
+  vector<pair<double, int> > scored; // (-similarity, actor)
+  vector<int> grams;
+  for (size_t i = 0; i < verified; i++) {
+    int actor = touched[i].second;
+    getTrigrams(pool + nameStart[actor], grams);
+    size_t shared = 0;
+    for (size_t q = 0, g = 0; q < query.size() && g < grams.size(); ) {
+      if (query[q] < grams[g]) q++;
+      else if (query[q] > grams[g]) g++;
+      else { shared++; q++; g++; }
+    }
+    scored.push_back(make_pair(-2.0 * shared / (query.size() + grams.size()), actor));
+  }
+  sort(scored.begin(), scored.end());
+  for (size_t i = 0; i < scored.size() && (int) i < limit; i++)
+    found.push_back(records[scored[i].second]);
+  return found.size();
+}
+
+/**
+ * A word starts at the beginning of a name and wherever a space is followed
+ * by something other than another space.
+ */
+
+bool suggestIndex::write(const string& fileName, const imdb& db)
+{
+  int actors = db.getNumActors();
+  vector<int> actorRecords, nameStarts, wordStarts, wordOwners;
+  string folded;
+  for (int a = 0; a < actors; a++) {
+    actorRecords.push_back(db.getActorRecordAt(a));
+    nameStarts.push_back(folded.size());
+    string name = foldName(db.getActorName(actorRecords.back()).c_str());
+    for (size_t i = 0; i < name.size(); i++) {
+      if (name[i] == ' ' || (i > 0 && name[i - 1] != ' ')) continue;
+      wordStarts.push_back(folded.size() + i);
+      wordOwners.push_back(a);
+    }
+    folded += name;
+    folded += '\0';
+  }
+  while (folded.size() % sizeof(int) != 0) folded += '\0';
+
+  vector<int> order(wordStarts.size());
+  for (size_t i = 0; i < order.size(); i++) order[i] = i;
+  const char *text = folded.c_str();
+  sort(order.begin(), order.end(), [&](int lhs, int rhs) {
+    return strcmp(text + wordStarts[lhs], text + wordStarts[rhs]) < 0;
+  });
+  vector<int> sortedWords, sortedOwners;
+  for (size_t i = 0; i < order.size(); i++) {
+    sortedWords.push_back(wordStarts[order[i]]);
+    sortedOwners.push_back(wordOwners[order[i]]);
+  }
+
+  vector<uint64_t> pairs; // trigram << 32 | actor
+  vector<int> grams;
+  for (int a = 0; a < actors; a++) {
+    getTrigrams(text + nameStarts[a], grams);
+    for (size_t i = 0; i < grams.size(); i++) pairs.push_back((uint64_t) grams[i] << 32 | a);
+  }
+  sort(pairs.begin(), pairs.end());
+  vector<int> keys, starts, entries;
+  for (size_t i = 0; i < pairs.size(); i++) {
+    int key = pairs[i] >> 32;
+    if (keys.empty() || keys.back() != key) {
+      keys.push_back(key);
+      starts.push_back(i);
+    }
+    entries.push_back((int) (pairs[i] & 0xffffffff));
+  }
+  starts.push_back(entries.size());
+
+  FILE *out = fopen(fileName.c_str(), "wb");
+  if (out == NULL) return false;
+  int header[kHeaderInts] = {
+    kMagic, kVersion, (int) db.getFileSize(imdb::ACTOR), actors, (int) sortedWords.size(),
+    (int) keys.size(), (int) entries.size(), (int) folded.size()
+  };
+  db.getDataStamp().store(header + kStampAt);
+  const vector<int> *arrays[] = {
+    &actorRecords, &nameStarts, &sortedWords, &sortedOwners, &keys, &starts, &entries
+  };
+  bool ok = fwrite(header, sizeof(int), kHeaderInts, out) == (size_t) kHeaderInts;
+  for (size_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]) && ok; i++)
+    ok = fwrite(arrays[i]->data(), sizeof(int), arrays[i]->size(), out) == arrays[i]->size();
+  ok = ok && fwrite(folded.data(), 1, folded.size(), out) == folded.size();
+  return fclose(out) == 0 && ok;
+}
+
+suggestIndex::~suggestIndex()
+{
+  if (fileMap != NULL) munmap((char *) fileMap, fileSize);
+}
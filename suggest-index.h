@@ -0,0 +1,128 @@
+#ifndef __suggest_index__
+#define __suggest_index__
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "data-format.h"
+using namespace std;
+
+class imdb;
+
+/**
+ * Class: suggestIndex
+ * -------------------
+ * Suggests actors for names typed loosely: by the prefix of any word of the
+ * name ("bac" finds Kevin Bacon), and by approximate match ("kevn bacon" does
+ * too).  It's kept in a sidecar file named actorsuggest, built by build-index,
+ * and mapped rather than read, so loading it costs nothing at startup.
+ *
+ * Names are case-folded (ASCII letters only; every other byte is kept as is)
+ * into a pool.  Prefix search runs over an array of word starts sorted by the
+ * folded text from that point on, so the matches for any prefix are one
+ * contiguous run found by binary search.  Approximate search uses trigrams of
+ * the folded names, padded as "  name ", with one sorted posting list of actor
+ * IDs per distinct trigram; candidates come from the query's rarest trigrams
+ * and are ranked by how many trigrams they share with the query.
+ *
+ * Actor IDs are positions in actordata's offset table.  The file layout, all
+ * native-endian 32-bit ints, is a header of kHeaderInts ints
+ *
+ *     magic, version, actor file size, number of actors, number of word starts,
+ *     number of trigrams, number of postings, folded name pool size,
+ *     data stamp[dataStamp::kInts] (see data-format.h)
+ *
+ * followed by
+ *
+ *     records[actors]            the record offset of each actor
+ *     nameStart[actors]          offset of each actor's folded name in the pool
+ *     words[word starts]         pool offsets of word starts, sorted by the text there
+ *     wordActors[word starts]    the actor each word start belongs to
+ *     trigrams[trigrams]         distinct trigrams (three bytes, packed), sorted
+ *     postingStart[trigrams + 1] the actors with trigram t are
+ *                                postings[postingStart[t] .. postingStart[t + 1])
+ *     postings[postings]         actor IDs
+ *
+ * and finally the pool, a run of NUL-terminated strings padded to four bytes.
+ */
+
+class suggestIndex {
+ public:
+
+  /**
+   * Constructor: suggestIndex
+   * -------------------------
+   * Constructs an index with nothing loaded; good() returns false
+   * until load succeeds.
+   */
+
+  suggestIndex();
+
+  /**
+   * Method: load
+   * ------------
+   * Maps the named index into memory, provided it exists, is well formed,
+   * and was built from an actor file of the specified size, from data files
+   * with the specified stamp.
+   *
+   * @return true if and only if the index is now ready for queries.
+   */
+
+  bool load(const string& fileName, size_t actorFileSize, const dataStamp& stamp);
+
+  bool good() const { return fileMap != NULL; }
+
+  /**
+   * Methods: suggestByPrefix
+   *          suggestSimilar
+   * ------------------------
+   * Find up to limit actors, each listed once, whose names have a word
+   * beginning with the specified text (ignoring case), or whose names are
+   * spelled most like the specified text.  Prefix matches come back in the
+   * order of the matching words; similar names come back best match first.
+   *
+   * @param records cleared, then filled with the record offsets of the actors found.
+   * @return the number of actors found.
+   */
+
+  int suggestByPrefix(const string& prefix, int limit, vector<int>& records) const;
+  int suggestSimilar(const string& name, int limit, vector<int>& records) const;
+
+  /**
+   * Method: write
+   * -------------
+   * Builds an index over every actor in the specified imdb and writes it to
+   * the named file.
+   *
+   * @return true if and only if the file was written successfully.
+   */
+
+  static bool write(const string& fileName, const imdb& db);
+
+  ~suggestIndex();
+
+ private:
+  static const int kMagic = 0x67677573; // "sugg"
+  static const int kVersion = 2;
+  static const int kStampAt = 8;
+  static const int kHeaderInts = kStampAt + dataStamp::kInts;
+
+  const void *fileMap;
+  size_t fileSize;
+  int numActors;
+  int numWords;
+  int numTrigrams;
+  const int *records;
+  const int *nameStart;
+  const int *words;
+  const int *wordActors;
+  const int *trigrams;
+  const int *postingStart;
+  const int *postings;
+  const char *pool;
+
+  suggestIndex(const suggestIndex& original);
+  suggestIndex& operator=(const suggestIndex& rhs);
+};
+
+#endif
@@ -0,0 +1,58 @@
+#include "worker-pool.h"
+using namespace std;
+
+workerPool::workerPool(int numThreads) :
+  numWorkers(numThreads < 1 ? 1 : numThreads), task(NULL), generation(0),
+  busyHelpers(0), stopping(false)
+{
+  for (int i = 1; i < numWorkers; i++)
+    helpers.push_back(thread(&workerPool::helperLoop, this, i));
+}
+
+void workerPool::run(const function<void(int)>& work)
+{
+  {
+    lock_guard<mutex> guard(lock);
+    task = &work;
+    busyHelpers = numWorkers - 1;
+    generation++;
+  }
+  taskReady.notify_all();
+  work(0);
+  unique_lock<mutex> guard(lock);
+  while (busyHelpers > 0) taskDone.wait(guard);
+  task = NULL;
+}
+
+/**
+ * Each helper remembers the last generation it ran, so a spurious
+ * wakeup never runs the same task twice.
+ */
+
+void workerPool::helperLoop(int worker)
+{
+  long lastGeneration = 0;
+  while (true) {
+    const function<void(int)> *work;
+    {
+      unique_lock<mutex> guard(lock);
+      while (!stopping && generation == lastGeneration) taskReady.wait(guard);
+      if (stopping) return;
+      lastGeneration = generation;
+      work = task;
+    }
+    (*work)(worker);
+    lock_guard<mutex> guard(lock);
+    if (--busyHelpers == 0) taskDone.notify_one();
+  }
+}
+
+workerPool::~workerPool()
+{
+  {
+    lock_guard<mutex> guard(lock);
+    stopping = true;
+  }
+  taskReady.notify_all();
+  for (size_t i = 0; i < helpers.size(); i++) helpers[i].join();
+}
@@ -0,0 +1,74 @@
+#ifndef __worker_pool__
+#define __worker_pool__
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+using namespace std;
+
+/**
+ * Class: workerPool
+ * -----------------
+ * A fixed set of threads that run one task at a time, all together.  The
+ * thread calling run takes part as worker 0, so a pool of size 1 starts no
+ * threads at all.  The threads are started once and then parked between tasks,
+ * which lets one pool serve every level of every search.
+ */
+
+class workerPool {
+ public:
+
+  /**
+   * Constructor: workerPool
+   * -----------------------
+   * Starts numThreads - 1 helper threads (numThreads is at least 1).
+   */
+
+  workerPool(int numThreads);
+
+  /**
+   * Method: size
+   * ------------
+   * Returns the number of workers, including the calling thread.
+   */
+
+  int size() const { return numWorkers; }
+
+  /**
+   * Method: run
+   * -----------
+   * Calls task(worker) once on each worker, for worker in [0, size()),
+   * and returns once every call has returned.  Only one thread may call
+   * run at a time, and task mustn't call run on the same pool.
+   */
+
+  void run(const function<void(int)>& task);
+
+  /**
+   * Destructor: ~workerPool
+   * -----------------------
+   * Stops and joins the helper threads.
+   */
+
+  ~workerPool();
+
+ private:
+  void helperLoop(int worker);
+
+  int numWorkers;
+  vector<thread> helpers;
+  mutex lock;
+  condition_variable taskReady;
+  condition_variable taskDone;
+  const function<void(int)> *task;
+  long generation;  // bumped once per call to run
+  int busyHelpers;
+  bool stopping;
+
+  workerPool(const workerPool& original);
+  workerPool& operator=(const workerPool& rhs);
+};
+
+#endif